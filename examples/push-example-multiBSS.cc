@@ -657,6 +657,8 @@ int main(int argc, char **argv)
 
 	uint32_t flag = 0;
 
+	uint32_t cache = 0;
+
 	CommandLine cmd;
 	cmd.AddValue ("sizeSource", "Number of nodes.", sizeSource);
 	cmd.AddValue ("sizeRouter", "Number of nodes.", sizeRouter);
@@ -698,6 +700,7 @@ int main(int argc, char **argv)
 	cmd.AddValue ("selectionw", "Selection Weight [0-1]", selectionWeight);
 	cmd.AddValue ("v", "Verbose", verbose);
 	cmd.AddValue ("ff", "flag", flag);
+	cmd.AddValue ("cache", "Chunks cached by the routers, 0 to disable", cache);
 	cmd.Parse(argc, argv);
 
 	if (pullactive)
@@ -803,6 +806,7 @@ int main(int argc, char **argv)
 			<< " --pullmax=" << pullmax
 			<< " --pulltime=" << pulltime
 			<< " --selectionw=" << selectionWeight
+			<< " --cache=" << cache
 			<< " --v=" << verbose
 			<< "\n";
 
@@ -1159,6 +1163,21 @@ int main(int argc, char **argv)
 		apps.Stop (Seconds (sourceStop));
 	}
 
+	if (cache > 0)
+	{
+		NS_LOG_INFO ("Application: create router caches");
+		for(uint32_t r = 0; r < routers.GetN() ; r++){
+			Ptr<ChunkCacheApplication> app = CreateObject<ChunkCacheApplication> ();
+			app->SetAttribute ("Local", AddressValue (ipRouter.GetAddress(r)));
+			app->SetAttribute ("LocalPort", UintegerValue (PUSH_PORT));
+			app->SetAttribute ("CacheSize", UintegerValue (cache));
+			app->SetAttribute ("HelloTime", TimeValue(Time::FromDouble(hellotime,Time::S)));
+			routers.Get(r)->AddApplication (app);
+			app->SetStartTime (Seconds (clientStart));
+			app->SetStopTime (Seconds (clientStop));
+		}
+	}
+
 	NS_LOG_INFO ("Application: create clients");
 	for(uint32_t n = 0; n < clients.GetN() ; n++){
 		InetSocketAddress dstC = InetSocketAddress (multicastGroup, PUSH_PORT);
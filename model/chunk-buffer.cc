@@ -139,6 +139,12 @@ namespace ns3
     return last;
   }
 
+  uint32_t
+  ChunkBuffer::GetFirstChunk ()
+  {
+    return (chunk_buffer.empty() ? 0 : chunk_buffer.begin()->first);
+  }
+
   uint32_t
   ChunkBuffer::GetSize ()
   {
@@ -180,6 +180,16 @@ namespace ns3
       uint32_t
       GetLastChunk ();
 
+      /**
+       *
+       * \return First chunk identifier, zero if the buffer is empty.
+       *
+       * Get the oldest chunk identifier in the buffer.
+       */
+
+      uint32_t
+      GetFirstChunk ();
+
       /**
        *
        * \return Chunk buffer size.
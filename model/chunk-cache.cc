@@ -0,0 +1,271 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2011 University of Trento, Italy
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * Authors: Alessandro Russo <russo@disi.unitn.it>
+ *          University of Trento, Italy
+ *
+ */
+
+#include "chunk-cache.h"
+#include "video-push.h"
+
+#include <ns3/log.h>
+#include <ns3/node.h>
+#include <ns3/nstime.h>
+#include <ns3/random-variable.h>
+#include <ns3/socket.h>
+#include <ns3/simulator.h>
+#include <ns3/packet.h>
+#include <ns3/uinteger.h>
+#include <ns3/trace-source-accessor.h>
+#include <ns3/udp-socket-factory.h>
+#include <ns3/inet-socket-address.h>
+#include <ns3/ipv4-header.h>
+#include <ns3/ipv4-l3-protocol.h>
+#include <ns3/udp-header.h>
+#include <stdio.h>
+
+NS_LOG_COMPONENT_DEFINE ("ChunkCacheApplication");
+
+namespace ns3
+{
+
+  NS_OBJECT_ENSURE_REGISTERED(ChunkCacheApplication);
+
+  const uint8_t UDP_PROT_NUMBER = 17;
+
+  TypeId
+  ChunkCacheApplication::GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::ChunkCacheApplication")
+      .SetParent<Application> ()
+      .AddConstructor<ChunkCacheApplication> ()
+      .AddAttribute ("Local", "Address of the interface towards the BSS",
+                     AddressValue (),
+                     MakeAddressAccessor (&ChunkCacheApplication::m_localAddress),
+                     MakeAddressChecker ())
+      .AddAttribute ("LocalPort", "Streaming port",
+                     UintegerValue (PUSH_PORT),
+                     MakeUintegerAccessor (&ChunkCacheApplication::m_localPort),
+                     MakeUintegerChecker<uint16_t> (1))
+      .AddAttribute ("Stream", "Stream cached, packets of other streams are ignored.",
+                     UintegerValue (0),
+                     MakeUintegerAccessor (&ChunkCacheApplication::m_stream),
+                     MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("CacheSize", "Max chunks cached, the oldest are dropped first.",
+                     UintegerValue (256),
+                     MakeUintegerAccessor (&ChunkCacheApplication::m_cacheSize),
+                     MakeUintegerChecker<uint32_t> (1))
+      .AddAttribute ("HelloTime", "Hello period.",
+                     TimeValue (Seconds (10)),
+                     MakeTimeAccessor (&ChunkCacheApplication::m_helloTime),
+                     MakeTimeChecker ())
+      .AddAttribute ("ReplyRate", "Upload budget refill rate for pull replies, zero for no budget.",
+                     DataRateValue (DataRate ("0bps")),
+                     MakeDataRateAccessor (&ChunkCacheApplication::m_replyRate),
+                     MakeDataRateChecker ())
+      .AddAttribute ("ReplyBurst", "Max bytes of pull replies sent in a burst.",
+                     UintegerValue (10000),
+                     MakeUintegerAccessor (&ChunkCacheApplication::m_replyBurst),
+                     MakeUintegerChecker<uint32_t> (1))
+      ;
+    return tid;
+  }
+
+  ChunkCacheApplication::ChunkCacheApplication () :
+      m_socket(0), m_localPort(PUSH_PORT), m_stream(0), m_cacheSize(256), m_helloTime(Seconds(10)),
+      m_helloTimer(Timer::CANCEL_ON_DESTROY), m_replyRate(0), m_replyBurst(10000),
+      m_statisticsStored(0), m_statisticsPull(0), m_statisticsHit(0)
+  {
+    NS_LOG_FUNCTION_NOARGS ();
+  }
+
+  ChunkCacheApplication::~ChunkCacheApplication ()
+  {
+    NS_LOG_FUNCTION_NOARGS ();
+  }
+
+  void
+  ChunkCacheApplication::DoDispose (void)
+  {
+    NS_LOG_FUNCTION_NOARGS ();
+    printf("Cache Node %d Stored %d Pulls %d Hits %d Size %d\n", GetNode()->GetId(), m_statisticsStored,
+        m_statisticsPull, m_statisticsHit, (uint32_t) m_chunks.GetBufferSize());
+    m_socket = 0;
+    Application::DoDispose();
+  }
+
+  void
+  ChunkCacheApplication::StartApplication (void)
+  {
+    NS_LOG_FUNCTION_NOARGS ();
+    NS_ASSERT_MSG(GetLocalAddress() != Ipv4Address(), "the cache needs the address of the BSS interface");
+    if (!m_socket)
+      {
+        m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+        int status = m_socket->Bind(InetSocketAddress(m_localPort));
+        NS_ASSERT(status != -1);
+        m_socket->SetAllowBroadcast(true);
+        m_socket->SetRecvCallback(MakeCallback(&ChunkCacheApplication::HandleReceive, this));
+      }
+    GetNode()->GetObject<Ipv4L3Protocol>()->TraceConnectWithoutContext("Rx",
+        MakeCallback(&ChunkCacheApplication::HandleForward, this));
+    m_replyBudget.SetRate(m_replyRate);
+    m_replyBudget.SetSize(m_replyBurst);
+    m_helloTimer.SetDelay(m_helloTime);
+    m_helloTimer.SetFunction(&ChunkCacheApplication::SendHello, this);
+    m_helloTimer.Schedule(Time::FromDouble(UniformVariable().GetValue(0, m_helloTime.GetSeconds() * .5), Time::S));
+  }
+
+  void
+  ChunkCacheApplication::StopApplication (void)
+  {
+    NS_LOG_FUNCTION_NOARGS ();
+    m_helloTimer.Cancel();
+    GetNode()->GetObject<Ipv4L3Protocol>()->TraceDisconnectWithoutContext("Rx",
+        MakeCallback(&ChunkCacheApplication::HandleForward, this));
+    if (m_socket)
+      {
+        m_socket->Close();
+        m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket> >());
+      }
+  }
+
+  Ipv4Address
+  ChunkCacheApplication::GetLocalAddress ()
+  {
+    return Ipv4Address::ConvertFrom(m_localAddress);
+  }
+
+  void
+  ChunkCacheApplication::HandleForward (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+  {
+    Ptr<Packet> copy = packet->Copy();
+    Ipv4Header ipH;
+    copy->RemoveHeader(ipH);
+    if (ipH.GetProtocol() != UDP_PROT_NUMBER || ipH.GetFragmentOffset() != 0 || !ipH.IsLastFragment())
+      return;
+    UdpHeader udpH;
+    copy->RemoveHeader(udpH);
+    if (udpH.GetDestinationPort() != m_localPort || copy->GetSize() < CHUNK_HEADER_SIZE + MSG_CHUNK_SIZE)
+      return;
+    ChunkHeader chunkH(MSG_CHUNK);
+    copy->RemoveHeader(chunkH);
+    if (chunkH.GetStream() == m_stream && chunkH.GetType() == MSG_CHUNK)
+      {
+        NS_LOG_LOGIC ("Cache " << GetLocalAddress() << " forwards chunk " << chunkH.GetChunkMessage().GetChunk().c_id
+            << " from " << ipH.GetSource() << " on interface " << interface);
+        StoreChunk(chunkH.GetChunkMessage().GetChunk());
+      }
+  }
+
+  void
+  ChunkCacheApplication::StoreChunk (const ChunkVideo &chunk)
+  {
+    if (!m_chunks.AddChunk(chunk, CHUNK_RECEIVED_PUSH))
+      return;
+    m_statisticsStored++;
+    while (m_chunks.GetBufferSize() > m_cacheSize)
+      m_chunks.DelChunk(m_chunks.GetFirstChunk());
+  }
+
+  void
+  ChunkCacheApplication::HandleReceive (Ptr<Socket> socket)
+  {
+    Ptr<Packet> packet;
+    Address from;
+    while ((packet = socket->RecvFrom(from)))
+      {
+        if (packet->GetSize() == 0 || !InetSocketAddress::IsMatchingType(from))
+          break;
+        Ipv4Address sender = InetSocketAddress::ConvertFrom(from).GetIpv4();
+        ChunkHeader chunkH(MSG_CHUNK);
+        packet->RemoveHeader(chunkH);
+        if (chunkH.GetStream() != m_stream)
+          continue;
+        switch (chunkH.GetType())
+          {
+          case MSG_PULL:
+            {
+              HandlePull(chunkH.GetPullMessage(), sender, chunkH.GetReserved());
+              break;
+            }
+          case MSG_CHUNK: // pull replies sent to the whole BSS
+            {
+              StoreChunk(chunkH.GetChunkMessage().GetChunk());
+              break;
+            }
+          default: // hellos, buffer maps and tree messages are not parsed
+            break;
+          }
+      }
+  }
+
+  void
+  ChunkCacheApplication::HandlePull (ChunkHeader::PullMessage &pullheader, const Ipv4Address &sender, uint8_t flags)
+  {
+    uint32_t chunkid = pullheader.GetChunk();
+    Ipv4Address target = pullheader.GetTarget();
+    Ptr<Ipv4> ipv4 = GetNode()->GetObject<Ipv4>();
+    bool anyone = (target == Ipv4Address::GetAny() || target.IsBroadcast()); // broadcast pull, anyone may reply
+    if ((flags & PULL_FLAG_SOURCE) || (!anyone && ipv4->GetInterfaceForAddress(target) < 0))
+      return;
+    m_statisticsPull++;
+    if (chunkid == 0 || !m_chunks.HasChunk(chunkid))
+      return;
+    ChunkVideo *copy = m_chunks.GetChunk(chunkid);
+    ChunkHeader chunk(MSG_CHUNK);
+    chunk.SetStream(m_stream);
+    chunk.GetChunkMessage().SetChunk(*copy);
+    chunk.GetChunkMessage().SetRequester(sender);
+    Ptr<Packet> packet = Create<Packet>(copy->GetSize());
+    packet->AddHeader(chunk);
+    if (!m_replyBudget.HasTokens(packet->GetSize()))
+      {
+        NS_LOG_DEBUG ("Cache " << GetLocalAddress() << " has no budget to reply chunk " << chunkid << " to " << sender);
+        return;
+      }
+    m_replyBudget.Consume(packet->GetSize());
+    m_statisticsHit++;
+    NS_LOG_LOGIC ("Cache " << GetLocalAddress() << " replies pull to " << sender << " for chunk [" << *copy << "]");
+    m_socket->SendTo(packet, 0, InetSocketAddress(sender, m_localPort));
+  }
+
+  void
+  ChunkCacheApplication::SendHello ()
+  {
+    NS_LOG_FUNCTION (this);
+    uint32_t first = m_chunks.GetFirstChunk();
+    uint32_t last = m_chunks.GetLastChunk();
+    uint32_t ratio = (first == 0 ? 1 : (uint32_t) ((1000.0 * m_chunks.GetBufferSize()) / (last - first + 1)));
+    ChunkHeader hello(MSG_HELLO);
+    hello.SetStream(m_stream);
+    hello.GetHelloMessage().SetLastChunk(last);
+    hello.GetHelloMessage().SetChunksReceived(m_chunks.GetBufferSize());
+    hello.GetHelloMessage().SetChunksRatio(ratio);
+    if (m_replyBudget.IsEnabled())
+      hello.GetHelloMessage().SetReplyBudget(m_replyBudget.GetTokens());
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(hello);
+    Ipv4Address subnet = GetLocalAddress().GetSubnetDirectedBroadcast(Ipv4Mask("255.0.0.0"));
+    NS_LOG_DEBUG ("Cache " << GetLocalAddress() << " sends hello to " << subnet << " last " << last);
+    m_socket->SendTo(packet, 0, InetSocketAddress(subnet, m_localPort));
+    m_helloTimer.Schedule();
+  }
+
+} // namespace ns3
@@ -0,0 +1,140 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2011 University of Trento, Italy
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * Authors: Alessandro Russo <russo@disi.unitn.it>
+ *          University of Trento, Italy
+ */
+
+#ifndef __CHUNK_CACHE_H__
+#define __CHUNK_CACHE_H__
+
+#include "chunk-buffer.h"
+#include "chunk-packet.h"
+#include "token-bucket.h"
+
+#include <ns3/address.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/application.h>
+#include <ns3/ptr.h>
+#include <ns3/data-rate.h>
+#include <ns3/ipv4.h>
+#include <ns3/timer.h>
+
+namespace ns3
+{
+
+  class Socket;
+  class Packet;
+
+  /**
+   * \brief In-network chunk cache for routers and access points.
+   *
+   * The application stores the chunks the node forwards, as seen on the IPv4 Rx trace,
+   * into a bounded buffer and answers the pulls of the peers in its BSS. Peers discover
+   * the cache through its hello messages as any other neighbor.
+   */
+
+  class ChunkCacheApplication : public Application
+  {
+
+    public:
+      static TypeId
+      GetTypeId (void);
+
+      ChunkCacheApplication ();
+
+      virtual
+      ~ChunkCacheApplication ();
+
+    protected:
+      virtual void
+      DoDispose (void);
+
+    private:
+      // inherited from Application base class.
+      virtual void
+      StartApplication (void);
+
+      // inherited from Application base class.
+      virtual void
+      StopApplication (void);
+
+      /**
+       * \param packet Packet received by the IPv4 layer, IPv4 header included.
+       * \param ipv4 IPv4 layer of the node.
+       * \param interface Incoming interface.
+       * Store the chunk carried by a packet the node forwards.
+       */
+      void
+      HandleForward (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+      /**
+       * \param socket Socket source.
+       * Parse the pulls addressed to the cache.
+       */
+      void
+      HandleReceive (Ptr<Socket> socket);
+
+      /**
+       * \param pullheader Pull header.
+       * \param sender Sender node.
+       * \param flags Pull flags.
+       * Reply to a pull if the chunk is cached and the upload budget allows it.
+       */
+      void
+      HandlePull (ChunkHeader::PullMessage &pullheader, const Ipv4Address &sender, uint8_t flags);
+
+      /**
+       * \param chunk Chunk forwarded or overheard.
+       * Store a chunk, dropping the oldest ones beyond the cache size.
+       */
+      void
+      StoreChunk (const ChunkVideo &chunk);
+
+      /**
+       * Advertise the cached chunks to the BSS.
+       */
+      void
+      SendHello ();
+
+      /**
+       * \return Local address.
+       * Get the cache address in the BSS.
+       */
+      Ipv4Address
+      GetLocalAddress ();
+
+      Ptr<Socket> m_socket;           /// Socket to receive pulls and send replies
+      Address m_localAddress;         /// Address of the BSS interface
+      uint16_t m_localPort;           /// Streaming port
+      uint32_t m_stream;              /// Stream cached
+      uint32_t m_cacheSize;           /// Max chunks cached
+      ChunkBuffer m_chunks;           /// Cached chunks
+      Time m_helloTime;               /// Hello period
+      Timer m_helloTimer;             /// Timer to send hello messages
+      DataRate m_replyRate;           /// Upload budget refill rate
+      uint32_t m_replyBurst;          /// Max bytes sent in a burst
+      TokenBucket m_replyBudget;      /// Upload budget for the replies
+      uint32_t m_statisticsStored;    /// Chunks stored
+      uint32_t m_statisticsPull;      /// Pulls addressed to the cache
+      uint32_t m_statisticsHit;       /// Pulls replied
+  };
+
+} // namespace ns3
+
+#endif // __CHUNK_CACHE_H__
@@ -43,11 +43,11 @@ namespace ns3
     NS_OBJECT_ENSURE_REGISTERED(ChunkHeader);
 
     ChunkHeader::ChunkHeader (ChunkMessageType type) :
-        m_type(type), m_reserved(0), m_checksum(0)
+        m_type(type), m_reserved(0), m_checksum(0), m_stream(0)
     {
     }
     ChunkHeader::ChunkHeader () :
-        m_type(MSG_HELLO), m_reserved(0), m_checksum(0)
+        m_type(MSG_HELLO), m_reserved(0), m_checksum(0), m_stream(0)
     {
     }
 
@@ -76,7 +76,7 @@ namespace ns3
     void
     ChunkHeader::SetType (ChunkMessageType type)
     {
-    NS_ASSERT (type >= MSG_PULL && type <= MSG_HELLO);
+    NS_ASSERT (type >= MSG_PULL && type <= MSG_NACK);
     m_type = type;
   }
 
@@ -104,6 +104,18 @@ ChunkHeader::SetChecksum (uint16_t checksum)
   m_checksum = checksum;
 }
 
+uint32_t
+ChunkHeader::GetStream ()
+{
+  return m_stream;
+}
+
+void
+ChunkHeader::SetStream (uint32_t stream)
+{
+  m_stream = stream;
+}
+
 uint32_t
 ChunkHeader::GetSerializedSize (void) const
 {
@@ -125,6 +137,26 @@ ChunkHeader::GetSerializedSize (void) const
         size += m_chunk_message.hello.GetSerializedSize();
         break;
       }
+    case MSG_BUFFERMAP:
+      {
+        size += m_chunk_message.buffermap.GetSerializedSize();
+        break;
+      }
+    case MSG_TREE:
+      {
+        size += m_chunk_message.tree.GetSerializedSize();
+        break;
+      }
+    case MSG_CLUSTER:
+      {
+        size += m_chunk_message.cluster.GetSerializedSize();
+        break;
+      }
+    case MSG_NACK:
+      {
+        size += m_chunk_message.nack.GetSerializedSize();
+        break;
+      }
     default:
       {
         NS_ASSERT(false);
@@ -137,7 +169,7 @@ ChunkHeader::GetSerializedSize (void) const
 void
 ChunkHeader::Print (std::ostream &os) const
 {
-  os << "ChunkHeader: Type=" << m_type << ", Resv=" << (uint16_t) m_reserved << ", Checksum=" << m_checksum << "\n";
+  os << "ChunkHeader: Type=" << m_type << ", Resv=" << (uint16_t) m_reserved << ", Checksum=" << m_checksum << ", Stream=" << m_stream << "\n";
 }
 
 void
@@ -148,6 +180,7 @@ ChunkHeader::Serialize (Buffer::Iterator start) const
   i.WriteU8(type);
   i.WriteU8(m_reserved);
   i.WriteHtonU16(m_checksum);
+  i.WriteHtonU32(m_stream);
   switch (m_type)
     {
     case MSG_PULL:
@@ -165,6 +198,26 @@ ChunkHeader::Serialize (Buffer::Iterator start) const
         m_chunk_message.hello.Serialize(i);
         break;
       }
+    case MSG_BUFFERMAP:
+      {
+        m_chunk_message.buffermap.Serialize(i);
+        break;
+      }
+    case MSG_TREE:
+      {
+        m_chunk_message.tree.Serialize(i);
+        break;
+      }
+    case MSG_CLUSTER:
+      {
+        m_chunk_message.cluster.Serialize(i);
+        break;
+      }
+    case MSG_NACK:
+      {
+        m_chunk_message.nack.Serialize(i);
+        break;
+      }
     default:
       {
         NS_ASSERT(false);
@@ -184,6 +237,8 @@ ChunkHeader::Deserialize (Buffer::Iterator start)
   size += 1;
   m_checksum = i.ReadNtohU16();
   size += 2;
+  m_stream = i.ReadNtohU32();
+  size += 4;
   switch (m_type)
     {
     case MSG_PULL:
@@ -201,6 +256,26 @@ ChunkHeader::Deserialize (Buffer::Iterator start)
         size += m_chunk_message.hello.Deserialize(i);
         break;
       }
+    case MSG_BUFFERMAP:
+      {
+        size += m_chunk_message.buffermap.Deserialize(i);
+        break;
+      }
+    case MSG_TREE:
+      {
+        size += m_chunk_message.tree.Deserialize(i);
+        break;
+      }
+    case MSG_CLUSTER:
+      {
+        size += m_chunk_message.cluster.Deserialize(i);
+        break;
+      }
+    case MSG_NACK:
+      {
+        size += m_chunk_message.nack.Deserialize(i);
+        break;
+      }
     default:
       {
         NS_ASSERT(false);
@@ -222,6 +297,10 @@ ChunkHeader::Deserialize (Buffer::Iterator start)
 //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //	|                   Chunk Attributes Size                       |
 //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|                     Requester Address                         |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|      TTL      |                  Reserved                     |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //	|                        Chunk Data                          ....
 //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //	|                        Chunk Attributes                    ....
@@ -241,7 +320,7 @@ ChunkHeader::ChunkMessage::GetSerializedSize (void) const
 void
 ChunkHeader::ChunkMessage::Print (std::ostream &os) const
 {
-  os << "ChunkHeader " << m_chunk << "\n";
+  os << "ChunkHeader " << m_chunk << " Requester " << m_requester << " TTL " << (uint32_t) m_ttl << "\n";
 }
 
 void
@@ -252,6 +331,10 @@ ChunkHeader::ChunkMessage::Serialize (Buffer::Iterator start) const
   i.WriteHtonU64(m_chunk.c_tstamp);
   i.WriteHtonU16(m_chunk.c_size);
   i.WriteHtonU16(m_chunk.c_attributes_size);
+  i.WriteHtonU32(m_requester.Get());
+  i.WriteU8(m_ttl);
+  i.WriteU8(0);
+  i.WriteHtonU16(0);
   // Do not send the actual data and attributes
 //  for(uint32_t s = 0; s < m_chunk.c_size ; s++){
 //  	  i.WriteU8(m_chunk.c_data[s]);
@@ -274,6 +357,12 @@ ChunkHeader::ChunkMessage::Deserialize (Buffer::Iterator start)
   size += 2;
   m_chunk.c_attributes_size = i.ReadNtohU16();
   size += 2;
+  m_requester = Ipv4Address(i.ReadNtohU32());
+  size += 4;
+  m_ttl = i.ReadU8();
+  i.ReadU8();
+  i.ReadNtohU16();
+  size += 4;
   // Do not send the actual data and attributes
 //  m_chunk.c_data = (uint8_t*)calloc(m_chunk.c_size, sizeof(uint8_t));
 //  for(uint32_t s = 0; s < m_chunk.c_size ; s++){
@@ -300,11 +389,39 @@ ChunkHeader::ChunkMessage::SetChunk (ChunkVideo chunk)
   m_chunk = chunk;
 }
 
+Ipv4Address
+ChunkHeader::ChunkMessage::GetRequester ()
+{
+  return m_requester;
+}
+
+void
+ChunkHeader::ChunkMessage::SetRequester (Ipv4Address requester)
+{
+  m_requester = requester;
+}
+
+uint8_t
+ChunkHeader::ChunkMessage::GetTtl ()
+{
+  return m_ttl;
+}
+
+void
+ChunkHeader::ChunkMessage::SetTtl (uint8_t ttl)
+{
+  m_ttl = ttl;
+}
+
 //	0               1               2               3
 //	0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
 //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //	|                      Chunk Identifier                         |
 //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|                       Target Address                          |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|                          Deadline                             |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 
 ChunkHeader::PullMessage::~PullMessage()
 {}
@@ -319,7 +436,7 @@ ChunkHeader::PullMessage::GetSerializedSize (void) const
 void
 ChunkHeader::PullMessage::Print (std::ostream &os) const
 {
-  os << "Pull chunk: " << m_chunkID << "\n";
+  os << "Pull chunk: " << m_chunkID << " Target " << m_target << " Deadline " << m_deadline << "\n";
 }
 
 void
@@ -327,6 +444,8 @@ ChunkHeader::PullMessage::Serialize (Buffer::Iterator start) const
 {
   Buffer::Iterator i = start;
   i.WriteHtonU32(m_chunkID);
+  i.WriteHtonU32(m_target.Get());
+  i.WriteHtonU32(m_deadline);
 }
 
 uint32_t
@@ -335,6 +454,8 @@ ChunkHeader::PullMessage::Deserialize (Buffer::Iterator start)
   Buffer::Iterator i = start;
   uint32_t size = MSG_PULL_SIZE;
   m_chunkID = i.ReadNtohU32();
+  m_target = Ipv4Address(i.ReadNtohU32());
+  m_deadline = i.ReadNtohU32();
   return size;
 }
 
@@ -351,11 +472,39 @@ ChunkHeader::PullMessage::SetChunk (uint32_t chunk)
   m_chunkID = chunk;
 }
 
+Ipv4Address
+ChunkHeader::PullMessage::GetTarget ()
+{
+  return m_target;
+}
+
+void
+ChunkHeader::PullMessage::SetTarget (Ipv4Address target)
+{
+  m_target = target;
+}
+
+uint32_t
+ChunkHeader::PullMessage::GetDeadline ()
+{
+  return m_deadline;
+}
+
+void
+ChunkHeader::PullMessage::SetDeadline (uint32_t deadline)
+{
+  m_deadline = deadline;
+}
+
 //	0               1               2               3
 //	0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
 //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //	|                      Chunks Received							|
 //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|                       Reply Budget                            |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|                        Substreams                             |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 
 ChunkHeader::HelloMessage::~HelloMessage()
 {}
@@ -371,7 +520,7 @@ void
 ChunkHeader::HelloMessage::Print (std::ostream &os) const
 {
   os << /*"Destination: " << m_destination <<*/", Last Chunk: " << m_lastChunk << ", Received: " << m_chunksRec
-      << ", Ratio: " << m_chunksRatio << /*", Neighborhood: " << m_neighborhoodSize << */"\n";
+      << ", Ratio: " << m_chunksRatio << ", Budget: " << m_replyBudget << ", Substreams: " << m_substreams << /*", Neighborhood: " << m_neighborhoodSize << */"\n";
 }
 
 void
@@ -382,6 +531,8 @@ ChunkHeader::HelloMessage::Serialize (Buffer::Iterator start) const
   i.WriteHtonU32(m_lastChunk);
   i.WriteHtonU32(m_chunksRec);
   i.WriteHtonU32(m_chunksRatio);
+  i.WriteHtonU32(m_replyBudget);
+  i.WriteHtonU32(m_substreams);
 //  i.WriteHtonU32 (m_neighborhoodSize);
 }
 
@@ -394,6 +545,8 @@ ChunkHeader::HelloMessage::Deserialize (Buffer::Iterator start)
   m_lastChunk = i.ReadNtohU32();
   m_chunksRec = i.ReadNtohU32();
   m_chunksRatio = i.ReadNtohU32();
+  m_replyBudget = i.ReadNtohU32();
+  m_substreams = i.ReadNtohU32();
 //  m_neighborhoodSize = i.ReadNtohU32();
   return size;
 }
@@ -449,6 +602,30 @@ ChunkHeader::HelloMessage::SetChunksRatio (uint32_t chunks)
   m_chunksRatio = chunks;
 }
 
+uint32_t
+ChunkHeader::HelloMessage::GetReplyBudget ()
+{
+  return m_replyBudget;
+}
+
+void
+ChunkHeader::HelloMessage::SetReplyBudget (uint32_t budget)
+{
+  m_replyBudget = budget;
+}
+
+uint32_t
+ChunkHeader::HelloMessage::GetSubstreams ()
+{
+  return m_substreams;
+}
+
+void
+ChunkHeader::HelloMessage::SetSubstreams (uint32_t mask)
+{
+  m_substreams = mask;
+}
+
 //uint32_t
 //ChunkHeader::HelloMessage::GetNeighborhoodSize ()
 //{
@@ -461,5 +638,315 @@ ChunkHeader::HelloMessage::SetChunksRatio (uint32_t chunks)
 //	m_neighborhoodSize = neighSize;
 //}
 
+//	0               1               2               3
+//	0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|                        Base Chunk                             |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|        Map Length (bytes)     |           Reserved            |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|                           Map                              ....
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+ChunkHeader::BufferMapMessage::~BufferMapMessage()
+{}
+
+uint32_t
+ChunkHeader::BufferMapMessage::GetSerializedSize (void) const
+{
+  uint32_t size = MSG_BUFFERMAP_SIZE + m_map.size();
+  return size;
+}
+
+void
+ChunkHeader::BufferMapMessage::Print (std::ostream &os) const
+{
+  os << "Base: " << m_base << ", Length: " << m_map.size() * 8 << "\n";
+}
+
+void
+ChunkHeader::BufferMapMessage::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU32(m_base);
+  i.WriteHtonU16(m_map.size());
+  i.WriteHtonU16(0);
+  for (std::vector<uint8_t>::const_iterator iter = m_map.begin(); iter != m_map.end(); iter++)
+    i.WriteU8(*iter);
+}
+
+uint32_t
+ChunkHeader::BufferMapMessage::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_base = i.ReadNtohU32();
+  uint16_t length = i.ReadNtohU16();
+  i.ReadNtohU16();
+  m_map.clear();
+  for (uint16_t b = 0; b < length; b++)
+    m_map.push_back(i.ReadU8());
+  return GetSerializedSize();
+}
+
+uint32_t
+ChunkHeader::BufferMapMessage::GetBase ()
+{
+  return m_base;
+}
+
+void
+ChunkHeader::BufferMapMessage::SetBase (uint32_t base)
+{
+  NS_ASSERT(m_map.empty());
+  m_base = base;
+}
+
+uint32_t
+ChunkHeader::BufferMapMessage::GetLength ()
+{
+  return m_map.size() * 8;
+}
+
+void
+ChunkHeader::BufferMapMessage::SetChunk (uint32_t chunkid)
+{
+  NS_ASSERT(chunkid >= m_base && chunkid - m_base < BUFFERMAP_MAX_CHUNKS);
+  uint32_t offset = chunkid - m_base;
+  if (m_map.size() <= offset / 8)
+    m_map.resize(offset / 8 + 1, 0);
+  m_map[offset / 8] |= (1 << (offset % 8));
+}
+
+bool
+ChunkHeader::BufferMapMessage::HasChunk (uint32_t chunkid)
+{
+  if (chunkid < m_base || chunkid - m_base >= GetLength())
+    return false;
+  uint32_t offset = chunkid - m_base;
+  return (m_map[offset / 8] & (1 << (offset % 8)));
+}
+
+//	0               1               2               3
+//	0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|    Opcode     |   Reserved    |          Free Slots           |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|                            Depth                              |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+ChunkHeader::TreeMessage::~TreeMessage()
+{}
+
+uint32_t
+ChunkHeader::TreeMessage::GetSerializedSize (void) const
+{
+  uint32_t size = MSG_TREE_SIZE;
+  return size;
+}
+
+void
+ChunkHeader::TreeMessage::Print (std::ostream &os) const
+{
+  os << "Opcode: " << m_opcode << ", Slots: " << m_slots << ", Depth: " << m_depth << "\n";
+}
+
+void
+ChunkHeader::TreeMessage::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteU8((uint8_t) m_opcode);
+  i.WriteU8(0);
+  i.WriteHtonU16(m_slots);
+  i.WriteHtonU32(m_depth);
+}
+
+uint32_t
+ChunkHeader::TreeMessage::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint32_t size = MSG_TREE_SIZE;
+  m_opcode = TreeOpcode(i.ReadU8());
+  i.ReadU8();
+  m_slots = i.ReadNtohU16();
+  m_depth = i.ReadNtohU32();
+  return size;
+}
+
+TreeOpcode
+ChunkHeader::TreeMessage::GetOpcode ()
+{
+  return m_opcode;
+}
+
+void
+ChunkHeader::TreeMessage::SetOpcode (TreeOpcode opcode)
+{
+  NS_ASSERT(opcode >= TREE_ADVERTISE && opcode <= TREE_LEAVE);
+  m_opcode = opcode;
+}
+
+uint16_t
+ChunkHeader::TreeMessage::GetSlots ()
+{
+  return m_slots;
+}
+
+void
+ChunkHeader::TreeMessage::SetSlots (uint16_t slots)
+{
+  m_slots = slots;
+}
+
+uint32_t
+ChunkHeader::TreeMessage::GetDepth ()
+{
+  return m_depth;
+}
+
+void
+ChunkHeader::TreeMessage::SetDepth (uint32_t depth)
+{
+  m_depth = depth;
+}
+
+//	0               1               2               3
+//	0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|    Opcode     |                  Reserved                     |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|                         Head Address                          |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+ChunkHeader::ClusterMessage::~ClusterMessage()
+{}
+
+uint32_t
+ChunkHeader::ClusterMessage::GetSerializedSize (void) const
+{
+  uint32_t size = MSG_CLUSTER_SIZE;
+  return size;
+}
+
+void
+ChunkHeader::ClusterMessage::Print (std::ostream &os) const
+{
+  os << "Opcode: " << m_opcode << ", Head: " << m_head << "\n";
+}
+
+void
+ChunkHeader::ClusterMessage::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteU8((uint8_t) m_opcode);
+  i.WriteU8(0);
+  i.WriteHtonU16(0);
+  i.WriteHtonU32(m_head.Get());
+}
+
+uint32_t
+ChunkHeader::ClusterMessage::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint32_t size = MSG_CLUSTER_SIZE;
+  m_opcode = ClusterOpcode(i.ReadU8());
+  i.ReadU8();
+  i.ReadNtohU16();
+  m_head = Ipv4Address(i.ReadNtohU32());
+  return size;
+}
+
+ClusterOpcode
+ChunkHeader::ClusterMessage::GetOpcode ()
+{
+  return m_opcode;
+}
+
+void
+ChunkHeader::ClusterMessage::SetOpcode (ClusterOpcode opcode)
+{
+  NS_ASSERT(opcode >= CLUSTER_REGISTER && opcode <= CLUSTER_REFERRAL);
+  m_opcode = opcode;
+}
+
+Ipv4Address
+ChunkHeader::ClusterMessage::GetHead ()
+{
+  return m_head;
+}
+
+void
+ChunkHeader::ClusterMessage::SetHead (Ipv4Address head)
+{
+  m_head = head;
+}
+
+//	0               1               2               3
+//	0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|                        First Chunk ID                         |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|             Count             |           Reserved            |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+ChunkHeader::NackMessage::~NackMessage()
+{}
+
+uint32_t
+ChunkHeader::NackMessage::GetSerializedSize (void) const
+{
+  uint32_t size = MSG_NACK_SIZE;
+  return size;
+}
+
+void
+ChunkHeader::NackMessage::Print (std::ostream &os) const
+{
+  os << "Nack first: " << m_first << ", Count: " << m_count << "\n";
+}
+
+void
+ChunkHeader::NackMessage::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU32(m_first);
+  i.WriteHtonU16(m_count);
+  i.WriteHtonU16(0);
+}
+
+uint32_t
+ChunkHeader::NackMessage::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint32_t size = MSG_NACK_SIZE;
+  m_first = i.ReadNtohU32();
+  m_count = i.ReadNtohU16();
+  i.ReadNtohU16();
+  return size;
+}
+
+uint32_t
+ChunkHeader::NackMessage::GetFirst ()
+{
+  return m_first;
+}
+
+void
+ChunkHeader::NackMessage::SetFirst (uint32_t first)
+{
+  m_first = first;
+}
+
+uint16_t
+ChunkHeader::NackMessage::GetCount ()
+{
+  return m_count;
+}
+
+void
+ChunkHeader::NackMessage::SetCount (uint16_t count)
+{
+  m_count = count;
+}
+
 }// namespace video
 } // namespace ns3
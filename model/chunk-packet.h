@@ -29,17 +29,49 @@
 #include <ns3/header.h>
 #include <ns3/ipv4-address.h>
 #include <iostream>
+#include <vector>
 
-const uint32_t CHUNK_HEADER_SIZE = 4;
-const uint32_t MSG_CHUNK_SIZE = (4 + 8 + 2 + 2);
-const uint32_t MSG_PULL_SIZE = 4;
-const uint32_t MSG_HELLO_SIZE = 4 * 3;
+const uint32_t CHUNK_HEADER_SIZE = 4 + 4;
+const uint32_t MSG_CHUNK_SIZE = (4 + 8 + 2 + 2 + 4 + 4);
+const uint32_t MSG_PULL_SIZE = 4 + 4 + 4;
+const uint32_t MSG_HELLO_SIZE = 4 * 5;
+const uint32_t MSG_BUFFERMAP_SIZE = 4 + 2 + 2; /// Fixed part, the map follows
+const uint32_t BUFFERMAP_MAX_CHUNKS = 1024; /// Max chunks advertised in a buffer map
+const uint32_t MSG_TREE_SIZE = 4 + 4;
+const uint32_t MSG_CLUSTER_SIZE = 4 + 4;
+const uint32_t MSG_NACK_SIZE = 4 + 2 + 2;
 
 enum ChunkMessageType
 {
-  MSG_PULL, MSG_CHUNK, MSG_HELLO
+  MSG_PULL, MSG_CHUNK, MSG_HELLO, MSG_BUFFERMAP, MSG_TREE, MSG_CLUSTER, MSG_NACK
 };
 
+enum TreeOpcode
+{
+  TREE_ADVERTISE, TREE_JOIN, TREE_ACCEPT, TREE_REJECT, TREE_LEAVE
+};
+
+enum ClusterOpcode
+{
+  CLUSTER_REGISTER, CLUSTER_REFERRAL
+};
+
+/// Depth advertised by nodes not connected to the tree.
+const uint32_t TREE_DEPTH_INFINITE = 0xFFFFFFFF;
+
+/// Flags carried in the reserved field of the chunk header.
+const uint8_t PULL_FLAG_BROADCAST = 0x01; /// The pull has been sent to all neighbors.
+const uint8_t PULL_FLAG_OVERHEAR = 0x02; /// The pull has been sent to all neighbors to be overheard, only the target replies.
+const uint8_t PULL_FLAG_SOURCE = 0x04; /// The pull has been sent to the source after neighbors failed to reply.
+const uint8_t PULL_FLAG_MESH = 0x08; /// The pull has been scheduled from buffer maps, replies are queued.
+const uint8_t PULL_FLAG_CLUSTER = 0x10; /// The pull has been sent over the backbone by the cluster head of another cell.
+const uint8_t CHUNK_FLAG_REPAIR = 0x20; /// The chunk has been pushed unrequested to fill a hole in a neighbor's buffer map.
+const uint8_t CHUNK_FLAG_SOURCE = 0x40; /// The chunk has been pushed by the source of its substream.
+const uint8_t CHUNK_FLAG_GOSSIP = 0x80; /// The chunk has been forwarded in gossip by a neighbor.
+
+/// Reply budget advertised in hello messages by nodes not bounding their upload.
+const uint32_t HELLO_BUDGET_UNLIMITED = 0xFFFFFFFF;
+
 namespace ns3
 {
   namespace streaming
@@ -54,6 +86,8 @@ namespace ns3
 //	0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
 //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //	|     Type      |   Reserved    |            Checksum           |
+//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//	|                          Stream                               |
 //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
     class ChunkHeader : public Header
     {
@@ -67,6 +101,7 @@ namespace ns3
         ChunkMessageType m_type;
         uint8_t m_reserved;
         uint16_t m_checksum;
+        uint32_t m_stream;
 
       public:
         ///\name Header serialization/deserialization
@@ -95,6 +130,10 @@ namespace ns3
         GetChecksum ();
         virtual void
         SetChecksum (uint16_t checksum);
+        virtual uint32_t
+        GetStream ();
+        virtual void
+        SetStream (uint32_t stream);
 
         //\}
 
@@ -110,6 +149,10 @@ namespace ns3
         //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
         //	|                   Chunk Attributes Size                       |
         //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|                     Requester Address                         |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|      TTL      |                  Reserved                     |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
         //	|                        Chunk Data                          ....
         //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
         //	|                        Chunk Attributes                    ....
@@ -118,13 +161,15 @@ namespace ns3
         struct ChunkMessage
         {
             ChunkMessage():
-              m_chunk()
+              m_chunk(), m_requester(Ipv4Address::GetAny()), m_ttl(0)
             {};
             ChunkMessage(ChunkVideo chunk):
-              m_chunk(chunk)
+              m_chunk(chunk), m_requester(Ipv4Address::GetAny()), m_ttl(0)
             {};
             virtual ~ChunkMessage();
             ChunkVideo m_chunk; // Chunk Data
+            Ipv4Address m_requester; // Node that pulled the chunk, any for pushed chunks
+            uint8_t m_ttl; // Hops a pushed chunk can still be forwarded by peers
             virtual void
             Print (std::ostream &os) const;
             virtual uint32_t
@@ -137,6 +182,14 @@ namespace ns3
             GetChunk ();
             virtual void
             SetChunk (ChunkVideo chunk);
+            virtual Ipv4Address
+            GetRequester ();
+            virtual void
+            SetRequester (Ipv4Address requester);
+            virtual uint8_t
+            GetTtl ();
+            virtual void
+            SetTtl (uint8_t ttl);
         };
 
         //	0               1               2               3
@@ -144,17 +197,23 @@ namespace ns3
         //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
         //	|                      Chunk Identifier                         |
         //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|                       Target Address                          |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|                          Deadline                             |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 
         struct PullMessage
         {
             PullMessage (uint32_t chunkId):
-              m_chunkID (chunkId)
+              m_chunkID (chunkId), m_target (Ipv4Address::GetAny()), m_deadline (0)
             {};
             PullMessage ():
-              m_chunkID (0)
+              m_chunkID (0), m_target (Ipv4Address::GetAny()), m_deadline (0)
             {};
             virtual ~PullMessage();
             uint32_t m_chunkID; // Chunk ID to pull
+            Ipv4Address m_target; // Neighbor asked to reply, any if every receiver may reply
+            uint32_t m_deadline; // Time left to the requester to play the chunk (us), 0 if unknown
             virtual void
             Print (std::ostream &os) const;
             virtual uint32_t
@@ -167,6 +226,14 @@ namespace ns3
             GetChunk ();
             virtual void
             SetChunk (uint32_t chunkid);
+            virtual Ipv4Address
+            GetTarget ();
+            virtual void
+            SetTarget (Ipv4Address target);
+            virtual uint32_t
+            GetDeadline ();
+            virtual void
+            SetDeadline (uint32_t deadline);
         };
 
         //	0               1               2               3
@@ -174,20 +241,27 @@ namespace ns3
         //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
         //	|                      Chunks Received							|
         //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|                       Reply Budget                            |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|                        Substreams                             |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 
         struct HelloMessage
         {
             HelloMessage ():
-              m_lastChunk (0), m_chunksRec (0), m_chunksRatio (0)
+              m_lastChunk (0), m_chunksRec (0), m_chunksRatio (0), m_replyBudget (HELLO_BUDGET_UNLIMITED), m_substreams (0)
               {}
             HelloMessage (uint32_t last, uint32_t rec, uint32_t ratio):
-              m_lastChunk (last), m_chunksRec (rec), m_chunksRatio (ratio)
+              m_lastChunk (last), m_chunksRec (rec), m_chunksRatio (ratio), m_replyBudget (HELLO_BUDGET_UNLIMITED),
+              m_substreams (0)
               {}
             virtual ~HelloMessage ();
 //	  Ipv4Address m_destination; // Destination Address
             uint32_t m_lastChunk; /// Chunks received
             uint32_t m_chunksRec; /// Chunks received
             uint32_t m_chunksRatio; /// Chunks ratio
+            uint32_t m_replyBudget; /// Bytes left to reply to pulls
+            uint32_t m_substreams; /// Substreams received in push, one bit per substream
 //  	  uint32_t m_neighborhoodSize; // Neighborhood size
             virtual void
             Print (std::ostream &os) const;
@@ -211,16 +285,173 @@ namespace ns3
             GetChunksRatio ();
             virtual void
             SetChunksRatio (uint32_t chunksRec);
+            virtual uint32_t
+            GetReplyBudget ();
+            virtual void
+            SetReplyBudget (uint32_t budget);
+            virtual uint32_t
+            GetSubstreams ();
+            virtual void
+            SetSubstreams (uint32_t mask);
 //  	  virtual uint32_t GetNeighborhoodSize ();
 //  	  virtual void SetNeighborhoodSize (uint32_t neighSize);
         };
 
+        //	0               1               2               3
+        //	0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|                        Base Chunk                             |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|        Map Length (bytes)     |           Reserved            |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|                           Map                              ....
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+        struct BufferMapMessage
+        {
+            BufferMapMessage ():
+              m_base (0)
+              {}
+            virtual ~BufferMapMessage ();
+            uint32_t m_base; /// First chunk of the map
+            std::vector<uint8_t> m_map; /// One bit per chunk from the base, set if held
+            virtual void
+            Print (std::ostream &os) const;
+            virtual uint32_t
+            GetSerializedSize (void) const;
+            virtual void
+            Serialize (Buffer::Iterator start) const;
+            virtual uint32_t
+            Deserialize (Buffer::Iterator start);
+            virtual uint32_t
+            GetBase ();
+            virtual void
+            SetBase (uint32_t base);
+            virtual uint32_t
+            GetLength ();
+            virtual void
+            SetChunk (uint32_t chunkid);
+            virtual bool
+            HasChunk (uint32_t chunkid);
+        };
+
+        //	0               1               2               3
+        //	0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|    Opcode     |   Reserved    |          Free Slots           |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|                            Depth                              |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+        struct TreeMessage
+        {
+            TreeMessage ():
+              m_opcode (TREE_ADVERTISE), m_slots (0), m_depth (TREE_DEPTH_INFINITE)
+              {}
+            virtual ~TreeMessage ();
+            TreeOpcode m_opcode; /// Tree operation
+            uint16_t m_slots; /// Children the sender can still accept
+            uint32_t m_depth; /// Hops from the source of the sender
+            virtual void
+            Print (std::ostream &os) const;
+            virtual uint32_t
+            GetSerializedSize (void) const;
+            virtual void
+            Serialize (Buffer::Iterator start) const;
+            virtual uint32_t
+            Deserialize (Buffer::Iterator start);
+            virtual TreeOpcode
+            GetOpcode ();
+            virtual void
+            SetOpcode (TreeOpcode opcode);
+            virtual uint16_t
+            GetSlots ();
+            virtual void
+            SetSlots (uint16_t slots);
+            virtual uint32_t
+            GetDepth ();
+            virtual void
+            SetDepth (uint32_t depth);
+        };
+
+        //	0               1               2               3
+        //	0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|    Opcode     |                  Reserved                     |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|                         Head Address                          |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+        struct ClusterMessage
+        {
+            ClusterMessage ():
+              m_opcode (CLUSTER_REGISTER), m_head (Ipv4Address::GetAny())
+              {}
+            virtual ~ClusterMessage ();
+            ClusterOpcode m_opcode; /// Cluster operation
+            Ipv4Address m_head; /// Cluster head referred by the source
+            virtual void
+            Print (std::ostream &os) const;
+            virtual uint32_t
+            GetSerializedSize (void) const;
+            virtual void
+            Serialize (Buffer::Iterator start) const;
+            virtual uint32_t
+            Deserialize (Buffer::Iterator start);
+            virtual ClusterOpcode
+            GetOpcode ();
+            virtual void
+            SetOpcode (ClusterOpcode opcode);
+            virtual Ipv4Address
+            GetHead ();
+            virtual void
+            SetHead (Ipv4Address head);
+        };
+
+        //	0               1               2               3
+        //	0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|                        First Chunk ID                         |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+        //	|             Count             |           Reserved            |
+        //	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+
+        struct NackMessage
+        {
+            NackMessage ():
+              m_first (0), m_count (0)
+              {}
+            virtual ~NackMessage ();
+            uint32_t m_first; /// First chunk missing
+            uint16_t m_count; /// Consecutive chunks missing
+            virtual void
+            Print (std::ostream &os) const;
+            virtual uint32_t
+            GetSerializedSize (void) const;
+            virtual void
+            Serialize (Buffer::Iterator start) const;
+            virtual uint32_t
+            Deserialize (Buffer::Iterator start);
+            virtual uint32_t
+            GetFirst ();
+            virtual void
+            SetFirst (uint32_t first);
+            virtual uint16_t
+            GetCount ();
+            virtual void
+            SetCount (uint16_t count);
+        };
+
       private:
         struct
         {
             ChunkMessage chunk;
             PullMessage pull;
             HelloMessage hello;
+            BufferMapMessage buffermap;
+            TreeMessage tree;
+            ClusterMessage cluster;
+            NackMessage nack;
         } m_chunk_message;
 
       public:
@@ -267,6 +498,62 @@ namespace ns3
           return m_chunk_message.hello;
         }
 
+        TreeMessage&
+        GetTreeMessage ()
+        {
+          if (m_type == 0)
+            {
+              m_type = MSG_TREE;
+            }
+          else
+            {
+              NS_ASSERT(m_type == MSG_TREE);
+            }
+          return m_chunk_message.tree;
+        }
+
+        ClusterMessage&
+        GetClusterMessage ()
+        {
+          if (m_type == 0)
+            {
+              m_type = MSG_CLUSTER;
+            }
+          else
+            {
+              NS_ASSERT(m_type == MSG_CLUSTER);
+            }
+          return m_chunk_message.cluster;
+        }
+
+        NackMessage&
+        GetNackMessage ()
+        {
+          if (m_type == 0)
+            {
+              m_type = MSG_NACK;
+            }
+          else
+            {
+              NS_ASSERT(m_type == MSG_NACK);
+            }
+          return m_chunk_message.nack;
+        }
+
+        BufferMapMessage&
+        GetBufferMapMessage ()
+        {
+          if (m_type == 0)
+            {
+              m_type = MSG_BUFFERMAP;
+            }
+          else
+            {
+              NS_ASSERT(m_type == MSG_BUFFERMAP);
+            }
+          return m_chunk_message.buffermap;
+        }
+
     };
 
   } //end namespace video
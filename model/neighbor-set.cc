@@ -24,6 +24,7 @@
 #include "neighbor-set.h"
 #include <ns3/simulator.h>
 #include <ns3/log.h>
+#include <math.h>
 
 NS_LOG_COMPONENT_DEFINE("NeighborSet");
 
@@ -118,6 +119,48 @@ namespace ns3
       n_chunksRatio = ratio;
     }
 
+    uint32_t
+    NeighborData::GetReplyBudget () const
+    {
+      return n_replyBudget;
+    }
+
+    void
+    NeighborData::SetReplyBudget (uint32_t budget)
+    {
+      n_replyBudget = budget;
+    }
+
+    void
+    NeighborData::SetBufferMap (const ChunkHeader::BufferMapMessage &map)
+    {
+      n_bufferMap = map;
+    }
+
+    uint32_t
+    NeighborData::GetSubstreams () const
+    {
+      return n_substreams;
+    }
+
+    void
+    NeighborData::SetSubstreams (uint32_t mask)
+    {
+      n_substreams = mask;
+    }
+
+    bool
+    NeighborData::HasBufferMap () const
+    {
+      return n_bufferMap.m_base > 0;
+    }
+
+    bool
+    NeighborData::HasChunk (uint32_t chunkid)
+    {
+      return n_bufferMap.HasChunk(chunkid);
+    }
+
     Ipv4Address
     Neighbor::GetAddress ()
     {
@@ -131,7 +174,7 @@ namespace ns3
     }
 
     NeighborsSet::NeighborsSet () :
-        m_selectionWeight(0), m_neighborProbability(0), m_expire(0)
+        m_selectionWeight(0), m_neighborProbability(0), m_expire(0), m_banditDiscount(1.0)
     {
       m_neighbor_set.clear();
       m_neighborProbVector.clear();
@@ -191,6 +234,17 @@ namespace ns3
       return m_neighbor_set.size();
     }
 
+    uint32_t
+    NeighborsSet::GetActiveSize ()
+    {
+      uint32_t active = 0;
+      for (std::map<Neighbor, NeighborData>::const_iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end();
+          iter++)
+        if (Simulator::Now() - iter->second.GetLastContact() <= GetExpire())
+          active++;
+      return active;
+    }
+
     NeighborData*
     NeighborsSet::GetNeighbor (Ipv4Address n_addr, uint32_t n_port)
     {
@@ -258,7 +312,7 @@ namespace ns3
     Neighbor
     NeighborsSet::SelectNeighbor (PeerPolicy policy)
     {
-      NS_ASSERT(policy>=PS_RANDOM && policy <= PS_BROADCAST);
+      NS_ASSERT(policy>=PS_RANDOM && policy <= PS_BANDIT);
       Purge();
       Neighbor target;
       if (!GetSize())
@@ -290,6 +344,11 @@ namespace ns3
             target = Neighbor(Ipv4Address::GetBroadcast(),0);
             break;
           }
+        case PS_BANDIT:
+          {
+            target = SelectPeerByBandit(std::set<Ipv4Address>());
+            break;
+          }
         default:
           {
             NS_ASSERT_MSG(false, "SelectNeighbor: invalid.");
@@ -299,6 +358,47 @@ namespace ns3
       return target;
     }
 
+    Neighbor
+    NeighborsSet::SelectNeighbor (PeerPolicy policy, const std::set<Ipv4Address> &exclude)
+    {
+      NS_ASSERT(policy>=PS_RANDOM && policy <= PS_BANDIT);
+      if (exclude.empty())
+        return SelectNeighbor(policy);
+      Purge();
+      Neighbor target;
+      if (!GetSize())
+        return target;
+      switch (policy)
+        {
+        case PS_RANDOM:
+          {
+            target = SelectPeerByRandom(exclude);
+            break;
+          }
+        case PS_SINR:
+          {
+            target = SelectPeerBySINR(exclude);
+            break;
+          }
+        case PS_BROADCAST:
+          {
+            target = Neighbor(Ipv4Address::GetBroadcast(),0);
+            break;
+          }
+        case PS_BANDIT:
+          {
+            target = SelectPeerByBandit(exclude);
+            break;
+          }
+        default:
+          {
+            NS_ASSERT_MSG(false, "SelectNeighbor: Not yet implemented.");
+            break;
+          }
+        }
+      return target;
+    }
+
     Neighbor
     NeighborsSet::SelectPeerByRandom ()
     {
@@ -306,6 +406,20 @@ namespace ns3
       return (GetSize() == 0 ? nt : GetNeighbor (UniformVariable().GetInteger(0, GetSize() - 1)));
     }
 
+    Neighbor
+    NeighborsSet::SelectPeerByRandom (const std::set<Ipv4Address> &exclude)
+    {
+      Neighbor nt;
+      std::vector<Neighbor> candidates;
+      for (std::map<Neighbor, NeighborData>::const_iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end();
+          iter++)
+        {
+          if (exclude.find(iter->first.n_address) == exclude.end())
+            candidates.push_back(iter->first);
+        }
+      return (candidates.empty() ? nt : candidates[UniformVariable().GetInteger(0, candidates.size() - 1)]);
+    }
+
     void
     NeighborsSet::SortNeighborhood (PeerPolicy policy)
     {
@@ -411,6 +525,199 @@ namespace ns3
       return nt;
     }
 
+    Neighbor
+    NeighborsSet::SelectPeerBySINR (const std::set<Ipv4Address> &exclude)
+    {
+      Neighbor nt;
+      if (m_neighbor_set.empty())
+        {
+          return nt;
+        }
+      if (m_neighborProbVector.empty())
+        SortNeighborhood(PS_SINR);
+      size_t nsize = m_neighbor_set.size();
+      double total = 0.0;
+      for (uint32_t id = 0; id < nsize; id++)
+        {
+          if (exclude.find(m_neighborProbVector[id].first.n_address) == exclude.end())
+            total += m_neighborProbability[id];
+        }
+      if (total <= 0)
+        return nt;
+      /* draw among the allowed neighbors, renormalizing their probabilities */
+      double random = UniformVariable().GetValue() * total;
+      for (uint32_t id = 0; id < nsize; id++)
+        {
+          if (exclude.find(m_neighborProbVector[id].first.n_address) != exclude.end())
+            continue;
+          nt = m_neighborProbVector[id].first;
+          random -= m_neighborProbability[id];
+          if (random <= 0)
+            break;
+        }
+      return nt;
+    }
+
+    Neighbor
+    NeighborsSet::SelectPeerByBandit (const std::set<Ipv4Address> &exclude)
+    {
+      Neighbor nt;
+      std::vector<Neighbor> fresh;
+      double total = 0.0;
+      for (std::map<Neighbor, NeighborData>::const_iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end();
+          iter++)
+        {
+          if (exclude.find(iter->first.n_address) != exclude.end())
+            continue;
+          total += iter->second.n_pulls;
+          if (iter->second.n_pulls <= 0.0) // never pulled, explore first
+            fresh.push_back(iter->first);
+        }
+      if (!fresh.empty())
+        return fresh[UniformVariable().GetInteger(0, fresh.size() - 1)];
+      /* UCB1 on discounted counts: hit ratio plus an exploration bonus */
+      double best = -1.0;
+      for (std::map<Neighbor, NeighborData>::const_iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end();
+          iter++)
+        {
+          if (exclude.find(iter->first.n_address) != exclude.end())
+            continue;
+          const NeighborData &data = iter->second;
+          double ucb = data.n_hits / data.n_pulls + sqrt(2.0 * log(1.0 + total) / data.n_pulls);
+          if (ucb > best)
+            {
+              best = ucb;
+              nt = iter->first;
+            }
+        }
+      return nt;
+    }
+
+    void
+    NeighborsSet::AddPullOutcome (Neighbor neighbor, bool hit)
+    {
+      for (std::map<Neighbor, NeighborData>::iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end(); iter++)
+        {
+          iter->second.n_pulls *= m_banditDiscount;
+          iter->second.n_hits *= m_banditDiscount;
+        }
+      NeighborData *data = GetNeighbor(neighbor);
+      if (!data)
+        return;
+      data->n_pulls += 1.0;
+      data->n_hits += (hit ? 1.0 : 0.0);
+    }
+
+    void
+    NeighborsSet::SetBanditDiscount (double discount)
+    {
+      NS_ASSERT(discount>0 && discount<=1);
+      m_banditDiscount = discount;
+    }
+
+    double
+    NeighborsSet::GetChunkAvailability (uint32_t chunkid)
+    {
+      NS_ASSERT(chunkid>0);
+      double holders = 0.0;
+      for (std::map<Neighbor, NeighborData>::iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end(); iter++)
+        {
+          uint32_t last = iter->second.GetLastChunk();
+          if (Simulator::Now() - iter->second.GetLastContact() > GetExpire())
+            continue;
+          if (iter->second.HasBufferMap()) // exact availability
+            {
+              holders += (iter->second.HasChunk(chunkid) ? 1.0 : 0.0);
+              continue;
+            }
+          if (last < chunkid)
+            continue;
+          double held = (1.0 * iter->second.GetBufferSize()) / last;
+          holders += (held > 1.0 ? 1.0 : held);
+        }
+      return holders;
+    }
+
+    void
+    NeighborsSet::GetHolders (uint32_t chunkid, std::vector<Neighbor> &holders)
+    {
+      for (std::map<Neighbor, NeighborData>::iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end(); iter++)
+        if (Simulator::Now() - iter->second.GetLastContact() <= GetExpire() && iter->second.HasChunk(chunkid))
+          holders.push_back(iter->first);
+    }
+
+    uint32_t
+    NeighborsSet::GetLastMapChunk ()
+    {
+      uint32_t last = 0;
+      for (std::map<Neighbor, NeighborData>::iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end(); iter++)
+        {
+          if (Simulator::Now() - iter->second.GetLastContact() > GetExpire() || !iter->second.HasBufferMap())
+            continue;
+          ChunkHeader::BufferMapMessage &map = iter->second.n_bufferMap;
+          for (uint32_t chunkid = map.GetBase() + map.GetLength(); chunkid > map.GetBase() && chunkid > last; chunkid--)
+            if (map.HasChunk(chunkid - 1))
+              {
+                last = chunkid - 1;
+                break;
+              }
+        }
+      return last;
+    }
+
+    void
+    NeighborsSet::GetDepleted (uint32_t bytes, std::set<Ipv4Address> &depleted)
+    {
+      for (std::map<Neighbor, NeighborData>::iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end(); iter++)
+        if (iter->second.GetReplyBudget() < bytes)
+          depleted.insert(iter->first.n_address);
+    }
+
+    void
+    NeighborsSet::GetMissingSubstream (uint32_t substream, std::set<Ipv4Address> &missing)
+    {
+      NS_ASSERT(substream < 32);
+      for (std::map<Neighbor, NeighborData>::iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end(); iter++)
+        {
+          uint32_t mask = iter->second.GetSubstreams();
+          if (mask && !(mask & (1 << substream)))
+            missing.insert(iter->first.n_address);
+        }
+    }
+
+    Ipv4Address
+    NeighborsSet::GetClusterCandidate (double sinr, double &ratio)
+    {
+      Ipv4Address best = Ipv4Address::GetAny();
+      ratio = 0.0;
+      for (std::map<Neighbor, NeighborData>::iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end(); iter++)
+        {
+          if (iter->second.GetSINR() < sinr)
+            continue;
+          double current = iter->second.GetChunkRatio();
+          if (best == Ipv4Address::GetAny() || current > ratio
+              || (current == ratio && best < iter->first.n_address))
+            {
+              best = iter->first.n_address;
+              ratio = current;
+            }
+        }
+      return best;
+    }
+
+    double
+    NeighborsSet::GetLinkQuality (Neighbor neighbor)
+    {
+      NeighborData *data = GetNeighbor(neighbor);
+      if (!data)
+        return 0.0;
+      double best = 0.0;
+      for (std::map<Neighbor, NeighborData>::const_iterator iter = m_neighbor_set.begin(); iter != m_neighbor_set.end();
+          iter++)
+        best = (iter->second.GetSINR() > best ? iter->second.GetSINR() : best);
+      return (best > 0 ? data->GetSINR() / best : 0.0);
+    }
+
     void
     NeighborsSet::SetExpire (Time time)
     {
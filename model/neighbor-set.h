@@ -24,10 +24,12 @@
 #define __NEIGHBORS_SET_H__
 
 #include "neighbor.h"
+#include "chunk-packet.h"
 #include <ns3/object.h>
 #include <ns3/simulator.h>
 #include <ns3/random-variable.h>
 #include <map>
+#include <set>
 
 namespace ns3
 {
@@ -35,7 +37,7 @@ using namespace streaming;
 
     enum PeerPolicy
     {
-      PS_RANDOM, PS_DELAY, PS_SINR, PS_ROUNDROBIN, PS_BROADCAST
+      PS_RANDOM, PS_DELAY, PS_SINR, PS_ROUNDROBIN, PS_BROADCAST, PS_BANDIT
     };
 
     enum PeerState
@@ -47,12 +49,12 @@ using namespace streaming;
     {
         NeighborData () :
             n_contact(Simulator::Now()), n_state(ACTIVE), n_bufferSize(0), n_latestChunk(0), n_sinr(0),
-            n_chunksRatio(0.0)
+            n_chunksRatio(0.0), n_replyBudget(HELLO_BUDGET_UNLIMITED), n_pulls(0.0), n_hits(0.0), n_substreams(0)
         {
         }
         NeighborData (Time start, PeerState state, uint32_t size, uint32_t c_id, double sinr, double cratio) :
             n_contact(start), n_state(state), n_bufferSize(size), n_latestChunk(c_id), n_sinr(sinr),
-            n_chunksRatio(cratio)
+            n_chunksRatio(cratio), n_replyBudget(HELLO_BUDGET_UNLIMITED), n_pulls(0.0), n_hits(0.0), n_substreams(0)
         {
         }
         Time n_contact;                 /// Last contact.
@@ -61,6 +63,11 @@ using namespace streaming;
         uint32_t n_latestChunk;         /// Neighbor latest chunk.
         double n_sinr;                  /// Neighbor SINR.
         double n_chunksRatio;           /// Neighbor chunks' ratio.
+        uint32_t n_replyBudget;         /// Neighbor bytes left to reply to pulls.
+        double n_pulls;                 /// Discounted pulls sent to the neighbor.
+        double n_hits;                  /// Discounted pulls answered by the neighbor in time.
+        ChunkHeader::BufferMapMessage n_bufferMap; /// Latest buffer map advertised by the neighbor.
+        uint32_t n_substreams;          /// Substreams the neighbor receives in push, one bit each.
 
         /**
          * \return time last contact.
@@ -151,6 +158,54 @@ using namespace streaming;
         void
         SetChunkRatio (double ratio);
 
+        /**
+         * \return Neighbor reply budget.
+         * Get neighbor bytes left to reply to pulls.
+         */
+        uint32_t
+        GetReplyBudget () const;
+
+        /**
+         * \param budget Neighbor reply budget.
+         * Set neighbor bytes left to reply to pulls.
+         */
+        void
+        SetReplyBudget (uint32_t budget);
+
+        /**
+         * \param map Neighbor buffer map.
+         * Set the latest buffer map advertised by the neighbor.
+         */
+        void
+        SetBufferMap (const ChunkHeader::BufferMapMessage &map);
+
+        /**
+         * \return Substreams received in push.
+         * Get the substreams the neighbor receives in push, one bit each.
+         */
+        uint32_t
+        GetSubstreams () const;
+
+        /**
+         * \param mask Substreams received in push.
+         * Set the substreams the neighbor receives in push, one bit each.
+         */
+        void
+        SetSubstreams (uint32_t mask);
+
+        /**
+         * \return True if the neighbor advertised a buffer map.
+         */
+        bool
+        HasBufferMap () const;
+
+        /**
+         * \param chunkid chunk identifier.
+         * \return True if the latest buffer map of the neighbor has the chunk.
+         */
+        bool
+        HasChunk (uint32_t chunkid);
+
         /**
          *
          * \param size chunk buffer size.
@@ -236,6 +291,12 @@ using namespace streaming;
         size_t
         GetSize ();
 
+        /**
+         * \return Number of neighbors heard within the expiration time.
+         */
+        uint32_t
+        GetActiveSize ();
+
         /**
          * \param addr Address.
          * \param port Port.
@@ -295,6 +356,15 @@ using namespace streaming;
         Neighbor
         SelectNeighbor (PeerPolicy policy);
 
+        /**
+         * \param policy Peer selection policy.
+         * \param exclude Addresses that must not be selected.
+         * \return Neighbor, null if every neighbor is excluded.
+         * Select a neighbor according to the given policy among the ones not excluded.
+         */
+        Neighbor
+        SelectNeighbor (PeerPolicy policy, const std::set<Ipv4Address> &exclude);
+
         /**
          * \return Neighbor.
          * Select a neighbor randomly.
@@ -302,6 +372,14 @@ using namespace streaming;
         Neighbor
         SelectPeerByRandom ();
 
+        /**
+         * \param exclude Addresses that must not be selected.
+         * \return Neighbor.
+         * Select a neighbor randomly among the ones not excluded.
+         */
+        Neighbor
+        SelectPeerByRandom (const std::set<Ipv4Address> &exclude);
+
         /**
          *
          * \param policy Criteria used to sort the neighbor vector.
@@ -317,6 +395,94 @@ using namespace streaming;
         Neighbor
         SelectPeerBySINR ();
 
+        /**
+         * \param exclude Addresses that must not be selected.
+         * \return Select a Neighbor by SINR
+         * Get a neighbor by SINR among the ones not excluded.
+         */
+        Neighbor
+        SelectPeerBySINR (const std::set<Ipv4Address> &exclude);
+
+        /**
+         * \param bytes Bytes of a reply.
+         * \param depleted Set where to add the neighbors.
+         * Add the neighbors whose advertised reply budget is below the given bytes.
+         */
+        void
+        GetDepleted (uint32_t bytes, std::set<Ipv4Address> &depleted);
+
+        /**
+         * \param substream Substream index.
+         * \param missing Set where to add the neighbors.
+         * Add the neighbors receiving some substreams in push, but not the given one.
+         */
+        void
+        GetMissingSubstream (uint32_t substream, std::set<Ipv4Address> &missing);
+
+        /**
+         * \param sinr Min SINR of the neighbors in the cell.
+         * \param ratio Chunk ratio of the neighbor returned.
+         * \return Neighbor with the best chunk ratio in the cell, any if none.
+         * Get the cell neighbor with the best chunk ratio, equal ratios broken by the higher address.
+         */
+        Ipv4Address
+        GetClusterCandidate (double sinr, double &ratio);
+
+        /**
+         * \param exclude Addresses that must not be selected.
+         * \return Select a Neighbor by UCB.
+         * Get the neighbor with the highest upper confidence bound on its pull hit ratio,
+         * neighbors never pulled first.
+         */
+        Neighbor
+        SelectPeerByBandit (const std::set<Ipv4Address> &exclude);
+
+        /**
+         * \param neighbor Neighbor pulled.
+         * \param hit True if the neighbor answered in time.
+         * Record the outcome of a pull, discounting the older outcomes of all neighbors.
+         */
+        void
+        AddPullOutcome (Neighbor neighbor, bool hit);
+
+        /**
+         * \param discount Discount factor of past pull outcomes.
+         * Set the discount factor of past pull outcomes.
+         */
+        void
+        SetBanditDiscount (double discount);
+
+        /**
+         * \param chunkid chunk identifier.
+         * \return Expected number of neighbors holding the chunk.
+         * Estimate how many neighbors hold the given chunk, according to
+         * their latest chunk and the fraction of chunks in their buffer.
+         */
+        double
+        GetChunkAvailability (uint32_t chunkid);
+
+        /**
+         * \param chunkid chunk identifier.
+         * \param holders Vector where to add the neighbors.
+         * Add the active neighbors whose buffer map has the given chunk.
+         */
+        void
+        GetHolders (uint32_t chunkid, std::vector<Neighbor> &holders);
+
+        /**
+         * \return Latest chunk advertised in the buffer maps of active neighbors, zero if none.
+         */
+        uint32_t
+        GetLastMapChunk ();
+
+        /**
+         * \param neighbor Neighbor.
+         * \return Link quality in [0,1], zero for unknown neighbors.
+         * Neighbor SINR relative to the best SINR in the neighborhood.
+         */
+        double
+        GetLinkQuality (Neighbor neighbor);
+
         /**
          * \param time Neighbor lifetime
          * Set Neighbor lifetime
@@ -343,6 +509,7 @@ using namespace streaming;
         double *m_neighborProbability;                   /// Pointer to array of probabilities.
         std::vector<NeigborPair> m_neighborProbVector;   /// Vector of neighbor pair to compute probabilities.
         Time m_expire;                                   /// Neighbor record expiration.
+        double m_banditDiscount;                         /// Discount factor of past pull outcomes.
 
         struct SnrCmp
         {
@@ -0,0 +1,114 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2011 University of Trento, Italy
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * Authors: Alessandro Russo <russo@disi.unitn.it>
+ *          University of Trento, Italy
+ *
+ */
+
+#include "token-bucket.h"
+#include <ns3/log.h>
+#include <ns3/simulator.h>
+
+NS_LOG_COMPONENT_DEFINE("TokenBucket");
+
+namespace ns3
+{
+
+  TokenBucket::TokenBucket () :
+      m_rate(0), m_size(0), m_tokens(0), m_last(Simulator::Now())
+  {
+  }
+
+  TokenBucket::TokenBucket (DataRate rate, uint32_t size) :
+      m_rate(rate), m_size(size), m_tokens(size), m_last(Simulator::Now())
+  {
+  }
+
+  TokenBucket::~TokenBucket ()
+  {
+  }
+
+  void
+  TokenBucket::SetRate (DataRate rate)
+  {
+    Refill();
+    m_rate = rate;
+  }
+
+  DataRate
+  TokenBucket::GetRate () const
+  {
+    return m_rate;
+  }
+
+  void
+  TokenBucket::SetSize (uint32_t size)
+  {
+    m_size = size;
+    m_tokens = size;
+    m_last = Simulator::Now();
+  }
+
+  uint32_t
+  TokenBucket::GetSize () const
+  {
+    return m_size;
+  }
+
+  bool
+  TokenBucket::IsEnabled () const
+  {
+    return m_rate.GetBitRate() > 0;
+  }
+
+  uint32_t
+  TokenBucket::GetTokens ()
+  {
+    Refill();
+    return (uint32_t) m_tokens;
+  }
+
+  bool
+  TokenBucket::HasTokens (uint32_t bytes)
+  {
+    return (!IsEnabled() || GetTokens() >= bytes);
+  }
+
+  bool
+  TokenBucket::Consume (uint32_t bytes)
+  {
+    if (!IsEnabled())
+      return true;
+    Refill();
+    bool enough = (m_tokens >= bytes);
+    m_tokens = (enough ? m_tokens - bytes : 0);
+    NS_LOG_DEBUG ("Bucket consumes " << bytes << " bytes, left " << m_tokens);
+    return enough;
+  }
+
+  void
+  TokenBucket::Refill ()
+  {
+    Time now = Simulator::Now();
+    double bytes = (now - m_last).GetSeconds() * m_rate.GetBitRate() / 8.0;
+    m_tokens = (m_tokens + bytes > m_size ? m_size : m_tokens + bytes);
+    m_last = now;
+  }
+
+} // namespace ns3
@@ -0,0 +1,129 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2011 University of Trento, Italy
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * Authors: Alessandro Russo <russo@disi.unitn.it>
+ *          University of Trento, Italy
+ */
+
+#ifndef __TOKEN_BUCKET_H__
+#define __TOKEN_BUCKET_H__
+
+#include <ns3/nstime.h>
+#include <ns3/data-rate.h>
+
+namespace ns3
+{
+
+  /**
+   * \brief Provide a byte token bucket to bound the upload of a node.
+   *
+   * Tokens are bytes refilled at a constant rate up to the bucket size.
+   * A bucket with a zero rate is disabled and never runs out of tokens.
+   */
+
+  class TokenBucket
+  {
+
+    public:
+
+      TokenBucket ();
+
+      /**
+       * \param rate Refill rate.
+       * \param size Bucket size in bytes.
+       */
+      TokenBucket (DataRate rate, uint32_t size);
+
+      virtual
+      ~TokenBucket ();
+
+      /**
+       * \param rate Refill rate.
+       * Set the refill rate, zero to disable the bucket.
+       */
+      void
+      SetRate (DataRate rate);
+
+      /**
+       * \return Refill rate.
+       * Get the refill rate.
+       */
+      DataRate
+      GetRate () const;
+
+      /**
+       * \param size Bucket size in bytes.
+       * Set the bucket size, the bucket is filled up.
+       */
+      void
+      SetSize (uint32_t size);
+
+      /**
+       * \return Bucket size in bytes.
+       * Get the bucket size.
+       */
+      uint32_t
+      GetSize () const;
+
+      /**
+       * \return True if the bucket bounds the upload.
+       * Check whether the bucket is enabled or not.
+       */
+      bool
+      IsEnabled () const;
+
+      /**
+       * \return Bytes available.
+       * Get the bytes available at the current time.
+       */
+      uint32_t
+      GetTokens ();
+
+      /**
+       * \param bytes Bytes to send.
+       * \return True if the bytes can be sent now.
+       * Check whether there are enough tokens to send the given bytes.
+       */
+      bool
+      HasTokens (uint32_t bytes);
+
+      /**
+       * \param bytes Bytes sent.
+       * \return True if there were enough tokens, false otherwise.
+       * Remove the tokens of the bytes sent, the bucket cannot go below zero.
+       */
+      bool
+      Consume (uint32_t bytes);
+
+    private:
+
+      /**
+       * Add the tokens accumulated since the last refill.
+       */
+      void
+      Refill ();
+
+      DataRate m_rate;  /// Refill rate
+      uint32_t m_size;  /// Bucket size in bytes
+      double m_tokens;  /// Bytes available
+      Time m_last;      /// Last refill time
+  };
+
+} // namespace ns3
+
+#endif // __TOKEN_BUCKET_H__
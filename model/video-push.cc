@@ -50,11 +50,10 @@
 #include <memory.h>
 #include <math.h>
 #include <stdio.h>
+#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE("VideoPushApplication");
 
-static uint32_t m_latestChunkID;
-
 namespace ns3
 {
 
@@ -70,7 +69,7 @@ namespace ns3
                      AddressValue (),
                      MakeAddressAccessor (&VideoPushApplication::m_localAddress),
                      MakeAddressChecker ())
-      .AddAttribute ("LocalPort", "Node main local port",
+      .AddAttribute ("LocalPort", "Node main local port, each application on a node needs its own.",
                      UintegerValue (PUSH_PORT),
                      MakeUintegerAccessor (&VideoPushApplication::m_localPort),
                      MakeUintegerChecker<uint16_t> (1))
@@ -109,13 +108,16 @@ namespace ns3
                                       PS_SINR, "SINR based selection.",
                                       PS_DELAY, "Delay based selection.",
                                       PS_ROUNDROBIN, "RoundRobin selection.",
-                                      PS_BROADCAST, "Pull is sent in broadcast."))
+                                      PS_BROADCAST, "Pull is sent in broadcast.",
+                                      PS_BANDIT, "Neighbor answering pulls in time most often, learned by UCB."))
       .AddAttribute ("ChunkPolicy", "Chunk selection algorithm.",
                      EnumValue(CS_LATEST),
                      MakeEnumAccessor(&VideoPushApplication::m_chunkSelection),
                      MakeEnumChecker (CS_LATEST, "Latest chunk",
                                       CS_LEAST_MISSED, "Least missed",
                                       CS_LATEST_MISSED, "Latest missed",
+                                      CS_LEAST_USEFUL, "Least useful (rarest first)",
+                                      CS_EARLIEST_DEADLINE, "Earliest deadline first",
                                       CS_NEW_CHUNK, "New chunks"))
       .AddAttribute ("PullTime", "Time between two consecutive pulls.",
                      TimeValue (MilliSeconds (50)),
@@ -132,6 +134,18 @@ namespace ns3
                      MakeUintegerAccessor (&VideoPushApplication::SetPullMax,
                                            &VideoPushApplication::GetPullMax),
                      MakeUintegerChecker<uint32_t> (0))
+      .AddAttribute ("PullHedge", "Send a second pull to another neighbor for chunks close to their deadline.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_pullHedge),
+                     MakeBooleanChecker() )
+      .AddAttribute ("PullHedgePercentile", "Percentile of the pull response time to wait before hedging.",
+                     DoubleValue (0.95),
+                     MakeDoubleAccessor (&VideoPushApplication::m_pullHedgePercentile),
+                     MakeDoubleChecker<double> (0.5, 1.0))
+      .AddAttribute ("PullBackoff", "Base of the jittered exponential backoff between two pulls of the same chunk (0 disables it).",
+                     TimeValue (Seconds (0)),
+                     MakeTimeAccessor (&VideoPushApplication::m_pullBackoff),
+                     MakeTimeChecker ())
       .AddAttribute ("PullActive", "Pull activation.",
                      BooleanValue (false),
                      MakeBooleanAccessor (&VideoPushApplication::SetPullActive,
@@ -142,6 +156,18 @@ namespace ns3
                      MakeUintegerAccessor (&VideoPushApplication::SetPullWindow,
                                            &VideoPushApplication::GetPullWindow),
                      MakeUintegerChecker<uint32_t> (50))
+      .AddAttribute ("PullWindowAdaptive", "Grow or shrink the pull window from loss burstiness and pull RTT.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_pullWindowAdaptive),
+                     MakeBooleanChecker() )
+      .AddAttribute ("PullWindowMin", "Min pull window size when adaptive, not below the PullWindow minimum.",
+                     UintegerValue (50),
+                     MakeUintegerAccessor (&VideoPushApplication::m_pullWindowMin),
+                     MakeUintegerChecker<uint32_t> (50))
+      .AddAttribute ("PullWindowMax", "Max pull window size when adaptive.",
+                     UintegerValue (100),
+                     MakeUintegerAccessor (&VideoPushApplication::m_pullWindowMax),
+                     MakeUintegerChecker<uint32_t> (50))
       .AddAttribute ("PullRatioMin", "Min ratio to activate pull.",
                      DoubleValue (0.80),
                      MakeDoubleAccessor (&VideoPushApplication::SetPullRatioMin,
@@ -152,6 +178,18 @@ namespace ns3
                      MakeDoubleAccessor (&VideoPushApplication::SetPullRatioMax,
                                          &VideoPushApplication::GetPullRatioMax),
                      MakeDoubleChecker<double> (0.80, 1.0))
+      .AddAttribute ("PullControlTime", "Period of the controller adjusting PullRatioMin and PullRatioMax, zero to disable.",
+                     TimeValue (Seconds (0)),
+                     MakeTimeAccessor (&VideoPushApplication::m_pullControlTime),
+                     MakeTimeChecker() )
+      .AddAttribute ("PullControlStep", "Change of PullRatioMin and PullRatioMax at each controller adjustment.",
+                     DoubleValue (0.02),
+                     MakeDoubleAccessor (&VideoPushApplication::m_pullControlStep),
+                     MakeDoubleChecker<double> (0.0, 0.1))
+      .AddAttribute ("PullControlHysteresis", "Consecutive control periods agreeing before the band is changed.",
+                     UintegerValue (2),
+                     MakeUintegerAccessor (&VideoPushApplication::m_pullControlHysteresis),
+                     MakeUintegerChecker<uint32_t> (1))
       .AddAttribute ("HelloLoss", "Number of allowed hello loss.",
                      UintegerValue (1),
                      MakeUintegerAccessor (&VideoPushApplication::SetHelloLoss,
@@ -171,11 +209,176 @@ namespace ns3
                      DoubleValue (0),
                      MakeDoubleAccessor (&VideoPushApplication::n_selectionWeight),
                      MakeDoubleChecker<double> (0))
+      .AddAttribute ("BanditDiscount", "Discount of past pull outcomes for the PS_BANDIT peer selection.",
+                     DoubleValue (0.95),
+                     MakeDoubleAccessor (&VideoPushApplication::n_banditDiscount),
+                     MakeDoubleChecker<double> (0.5, 1.0))
+      .AddAttribute ("PullReplyRate", "Upload budget refill rate for pull replies, zero for no budget.",
+                     DataRateValue (DataRate ("0bps")),
+                     MakeDataRateAccessor (&VideoPushApplication::m_pullReplyRate),
+                     MakeDataRateChecker ())
+      .AddAttribute ("PullReplyBurst", "Max bytes of pull replies sent in a burst.",
+                     UintegerValue (10000),
+                     MakeUintegerAccessor (&VideoPushApplication::m_pullReplyBurst),
+                     MakeUintegerChecker<uint32_t> (1))
+      .AddAttribute ("SourceReplyRate", "Upload budget refill rate of the source for pull replies, zero to never reply.",
+                     DataRateValue (DataRate ("0bps")),
+                     MakeDataRateAccessor (&VideoPushApplication::m_sourceReplyRate),
+                     MakeDataRateChecker ())
+      .AddAttribute ("PullSource", "Send one more pull for a chunk to the source after PullMax neighbor pulls failed.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_pullSource),
+                     MakeBooleanChecker() )
       .AddAttribute ("MaxPullReply", "Max number of pull to reply.",
                      UintegerValue (1),
                      MakeUintegerAccessor (&VideoPushApplication::SetPullReplyMax,
                                            &VideoPushApplication::GetPullReplyMax),
                      MakeUintegerChecker<uint32_t> (0))
+      .AddAttribute ("PullJitterAdaptive", "Scale the pull and reply jitter with active neighbors and pull timeouts.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_pullJitterAdaptive),
+                     MakeBooleanChecker() )
+      .AddAttribute ("PullJitterNeighbors", "Active neighbors covered by the default jitter window.",
+                     UintegerValue (4),
+                     MakeUintegerAccessor (&VideoPushApplication::m_pullJitterNeighbors),
+                     MakeUintegerChecker<uint32_t> (1))
+      .AddAttribute ("PullJitterScaleMax", "Max scale of the jitter window.",
+                     DoubleValue (8.0),
+                     MakeDoubleAccessor (&VideoPushApplication::m_pullJitterScaleMax),
+                     MakeDoubleChecker<double> (1.0))
+      .AddAttribute ("PullRateControl", "Pace pulls with an AIMD rate driven by pull hits and timeouts.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_pullRateControl),
+                     MakeBooleanChecker() )
+      .AddAttribute ("PullRateMin", "Min pull rate (pulls/s).",
+                     DoubleValue (10.0),
+                     MakeDoubleAccessor (&VideoPushApplication::m_pullRateMin),
+                     MakeDoubleChecker<double> (0.1))
+      .AddAttribute ("PullRateMax", "Max pull rate (pulls/s).",
+                     DoubleValue (1000.0),
+                     MakeDoubleAccessor (&VideoPushApplication::m_pullRateMax),
+                     MakeDoubleChecker<double> (0.1))
+      .AddAttribute ("PullRateIncrease", "Pull rate increase on each pull hit (pulls/s).",
+                     DoubleValue (10.0),
+                     MakeDoubleAccessor (&VideoPushApplication::m_pullRateIncrease),
+                     MakeDoubleChecker<double> (0.0))
+      .AddAttribute ("PullRateDecrease", "Pull rate multiplicative decrease on each pull timeout.",
+                     DoubleValue (0.5),
+                     MakeDoubleAccessor (&VideoPushApplication::m_pullRateDecrease),
+                     MakeDoubleChecker<double> (0.0, 1.0))
+      .AddAttribute ("PullOverhear", "Send pulls to all neighbors and hold own pulls for chunks requested by a neighbor.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_pullOverhear),
+                     MakeBooleanChecker() )
+      .AddAttribute ("PullReplyAggregation", "Window to coalesce pulls for the same chunk into one broadcast reply, zero to disable.",
+                     TimeValue (Seconds (0)),
+                     MakeTimeAccessor (&VideoPushApplication::m_pullReplyAggregation),
+                     MakeTimeChecker() )
+      .AddAttribute ("PullReplySuppression", "Cancel a reply to a broadcast pull when another neighbor replies first.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_pullReplySuppression),
+                     MakeBooleanChecker() )
+      .AddAttribute ("GossipFanout", "Neighbors a fresh pushed chunk is forwarded to, zero to disable gossip.",
+                     UintegerValue (0),
+                     MakeUintegerAccessor (&VideoPushApplication::m_gossipFanout),
+                     MakeUintegerChecker<uint32_t> (0))
+      .AddAttribute ("GossipProbability", "Probability to forward a fresh pushed chunk.",
+                     DoubleValue (1.0),
+                     MakeDoubleAccessor (&VideoPushApplication::m_gossipProbability),
+                     MakeDoubleChecker<double> (0.0, 1.0))
+      .AddAttribute ("GossipTtl", "Hops a chunk pushed by the source can be forwarded by peers.",
+                     UintegerValue (0),
+                     MakeUintegerAccessor (&VideoPushApplication::m_gossipTtl),
+                     MakeUintegerChecker<uint32_t> (0, 255))
+      .AddAttribute ("BufferMapTime", "Period of the buffer maps sent to neighbors, zero to disable.",
+                     TimeValue (Seconds (0)),
+                     MakeTimeAccessor (&VideoPushApplication::m_bufferMapTime),
+                     MakeTimeChecker() )
+      .AddAttribute ("RepairPush", "Push held chunks missing from the neighbors' buffer maps, earliest deadline first, within the reply budget.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_repairPush),
+                     MakeBooleanChecker() )
+      .AddAttribute ("MeshPull", "Pull chunks advertised in the neighbors' buffer maps instead of running the pull loop.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_meshPull),
+                     MakeBooleanChecker() )
+      .AddAttribute ("MeshPullTime", "Period of the mesh pull scheduler.",
+                     TimeValue (Seconds (0.1)),
+                     MakeTimeAccessor (&VideoPushApplication::m_meshPullTime),
+                     MakeTimeChecker() )
+      .AddAttribute ("MeshPullBatch", "Max pulls sent at each period of the mesh pull scheduler.",
+                     UintegerValue (8),
+                     MakeUintegerAccessor (&VideoPushApplication::m_meshPullBatch),
+                     MakeUintegerChecker<uint32_t> (1))
+      .AddAttribute ("SourceSeeds", "Neighbors the source sends each chunk to, zero to multicast.",
+                     UintegerValue (0),
+                     MakeUintegerAccessor (&VideoPushApplication::m_sourceSeeds),
+                     MakeUintegerChecker<uint32_t> (0))
+      .AddAttribute ("Unicast", "The source pushes each chunk in unicast to its subscribers, peers report their last chunk to the source.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_unicast),
+                     MakeBooleanChecker() )
+      .AddAttribute ("TreeOverlay", "Push chunks down an application-level tree instead of IP multicast.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_tree),
+                     MakeBooleanChecker() )
+      .AddAttribute ("TreeFanoutMax", "Max children per node in the tree overlay.",
+                     UintegerValue (4),
+                     MakeUintegerAccessor (&VideoPushApplication::m_treeFanoutMax),
+                     MakeUintegerChecker<uint32_t> (1, 65535))
+      .AddAttribute ("Substreams", "Substreams the stream is split into, chunk id modulo substreams.",
+                     UintegerValue (1),
+                     MakeUintegerAccessor (&VideoPushApplication::m_substreams),
+                     MakeUintegerChecker<uint32_t> (1, 32))
+      .AddAttribute ("Substream", "Substream pushed by the source, from zero.",
+                     UintegerValue (0),
+                     MakeUintegerAccessor (&VideoPushApplication::m_substream),
+                     MakeUintegerChecker<uint32_t> (0, 31))
+      .AddAttribute ("Stream", "Stream carried by the application, packets of other streams are dropped. "
+                     "Applications of different streams on the same node must use different local ports.",
+                     UintegerValue (0),
+                     MakeUintegerAccessor (&VideoPushApplication::m_stream),
+                     MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("Cluster", "Elect a cluster head per cell pulling the chunks missed by the cell from the heads of other cells.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_cluster),
+                     MakeBooleanChecker() )
+      .AddAttribute ("ClusterSinr", "Min SINR of a neighbor to be in the same cell for the election.",
+                     DoubleValue (0.0),
+                     MakeDoubleAccessor (&VideoPushApplication::m_clusterSinr),
+                     MakeDoubleChecker<double> (0.0))
+      .AddAttribute ("ClusterTtl", "TTL of the messages exchanged by the cluster heads over the backbone.",
+                     UintegerValue (64),
+                     MakeUintegerAccessor (&VideoPushApplication::m_clusterTtl),
+                     MakeUintegerChecker<uint32_t> (1, 255))
+      .AddAttribute ("Nack", "Peers report the chunks skipped by the push, the source re-multicasts the ones reported enough.",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&VideoPushApplication::m_nack),
+                     MakeBooleanChecker() )
+      .AddAttribute ("NackDelay", "Max random delay of a NACK, a retransmission received meanwhile suppresses it.",
+                     TimeValue (MilliSeconds (50)),
+                     MakeTimeAccessor (&VideoPushApplication::m_nackDelay),
+                     MakeTimeChecker() )
+      .AddAttribute ("NackWindow", "Time the source aggregates the NACKs before retransmitting.",
+                     TimeValue (MilliSeconds (20)),
+                     MakeTimeAccessor (&VideoPushApplication::m_nackWindow),
+                     MakeTimeChecker() )
+      .AddAttribute ("NackTtl", "TTL of the NACKs sent to the source.",
+                     UintegerValue (64),
+                     MakeUintegerAccessor (&VideoPushApplication::m_nackTtl),
+                     MakeUintegerChecker<uint32_t> (1, 255))
+      .AddAttribute ("NackThreshold", "NACKs within the window needed to retransmit a chunk.",
+                     UintegerValue (1),
+                     MakeUintegerAccessor (&VideoPushApplication::m_nackThreshold),
+                     MakeUintegerChecker<uint32_t> (1))
+      .AddAttribute ("NackRate", "Retransmission budget refill rate at the source, zero for no budget.",
+                     DataRateValue (DataRate ("0bps")),
+                     MakeDataRateAccessor (&VideoPushApplication::m_nackRate),
+                     MakeDataRateChecker ())
+      .AddAttribute ("NackBurst", "Max bytes retransmitted in a burst.",
+                     UintegerValue (10000),
+                     MakeUintegerAccessor (&VideoPushApplication::m_nackBurst),
+                     MakeUintegerChecker<uint32_t> (1))
       .AddAttribute ("ChunkDelay", "Chunk Delay Trace",
                      PointerValue (),
                      MakePointerAccessor (&VideoPushApplication::m_delay),
@@ -209,12 +412,37 @@ namespace ns3
   VideoPushApplication::VideoPushApplication () :
       m_socket(0), m_localAddress(Ipv4Address::GetAny()), m_localPort(0), m_peerType(PEER), m_ipv4(0),
       m_source(Ipv4Address::GetAny()), m_gateway(Ipv4Address::GetAny()), m_totalRx(0), m_connected(false), m_pktSize(0),
-      m_residualBits(0), m_lastStartTime(0), m_maxBytes(0), m_totBytes(0), m_playoutWindow(0), m_chunkRatioMin(0),
+      m_residualBits(0), m_lastStartTime(0), m_maxBytes(0), m_totBytes(0), m_playoutWindow(0),
+      m_pullWindowAdaptive(false), m_pullWindowMin(50), m_pullWindowMax(100), m_chunkRatioMin(0),
       m_chunkRatioMax(0), m_pullActive(false), m_pullSlot(0), m_pullSlotStart(0), m_pullChunkMissed(0),
-      m_pullReplyMax(0), m_pullReplyCurrent(0), m_pullReplyTimer(Timer::CANCEL_ON_DESTROY), m_pullTimeout(0),
-      m_pullTimer(Timer::CANCEL_ON_DESTROY), m_pullRetriesMax(0), m_pullWBase(0), m_playout(Timer::CANCEL_ON_DESTROY),
+      m_pullReplyMax(0), m_pullReplyCurrent(0), m_pullReplyTimer(Timer::CANCEL_ON_DESTROY),
+      m_pullReplySuppression(false), m_pullReplyChunk(0), m_pullReplyTarget(Ipv4Address::GetAny()),
+      m_pullReplyAggregation(Seconds(0)), m_pullReplyRate(0), m_pullReplyBurst(10000),
+      m_sourceReplyRate(0), m_pullSource(false), m_pullTimeout(0),
+      m_pullTimer(Timer::CANCEL_ON_DESTROY), m_pullOutstanding(0), m_pullTarget(Ipv4Address::GetAny()),
+      m_pullJitterAdaptive(false), m_pullJitterNeighbors(4), m_pullJitterScaleMax(8.0), m_pullTimeoutRate(0.0),
+      m_pullRateControl(false), m_pullRateMin(10.0), m_pullRateMax(1000.0), m_pullRateIncrease(10.0), m_pullRateDecrease(0.5),
+      m_pullRate(1000.0), m_pullLastSent(0),
+      m_pullOverhear(false), m_pullRetriesMax(0), m_pullWBase(0), m_playout(Timer::CANCEL_ON_DESTROY),
+      m_pullControlTime(0), m_pullControlStep(0.02), m_pullControlHysteresis(2), m_pullControlTimer(Timer::CANCEL_ON_DESTROY),
+      m_pullControlTrend(0), m_pullControlRequest(0), m_pullControlHit(0), m_pullControlReceived(0), m_pullControlReply(0), m_pullMisses(0), m_pullControlMisses(0), m_pullRtt(0),
+      m_pullHedge(false), m_pullHedgePercentile(0), m_pullBackoff(0),
       m_statisticsPullRequest(0), m_statisticsPullReceived(0), m_statisticsPullReply(0), m_statisticsPullHit(0),
+      m_statisticsPullHedge(0), m_statisticsPullHedgeDup(0), m_statisticsPullSuppressed(0),
+      m_statisticsPullHeld(0), m_statisticsPullOverheard(0), m_statisticsPullCoalesced(0),
+      m_statisticsPullDiscard(0), m_statisticsPullNoBudget(0), m_statisticsGossipTx(0), m_statisticsGossipRx(0),
+      m_gossipFanout(0), m_gossipProbability(1.0), m_gossipTtl(0),
       m_helloActive(0), m_helloTime(0), m_helloTimer(Timer::CANCEL_ON_DESTROY), m_helloLoss(0),
+      m_bufferMapTime(0), m_bufferMapTimer(Timer::CANCEL_ON_DESTROY), m_meshPull(false), m_meshPullTime(0),
+      m_meshPullBatch(8), m_meshTimer(Timer::CANCEL_ON_DESTROY), m_sourceSeeds(0),
+      m_unicast(false), m_unicastPacket(0), m_unicastGap(0),
+      m_repairPush(false), m_repairTimer(Timer::CANCEL_ON_DESTROY), m_statisticsRepairTx(0), m_statisticsRepairRx(0),
+      m_stream(0), m_latestChunk(0), m_substreams(1), m_substream(0), m_tree(false), m_treeFanoutMax(4), m_treeTimer(Timer::CANCEL_ON_DESTROY), m_treeParent(Ipv4Address::GetAny()),
+      m_treeJoining(Ipv4Address::GetAny()), m_treeDepth(TREE_DEPTH_INFINITE),
+      m_cluster(false), m_clusterSinr(0.0), m_clusterTtl(64), m_clusterTimer(Timer::CANCEL_ON_DESTROY), m_clusterHead(false),
+      m_statisticsClusterPull(0), m_statisticsClusterRelay(0),
+      m_nack(false), m_nackDelay(MilliSeconds(50)), m_nackWindow(MilliSeconds(20)), m_nackTtl(64), m_nackThreshold(1), m_nackRate(0),
+      m_nackBurst(10000), m_statisticsNackTx(0), m_statisticsNackRx(0), m_statisticsNackRetx(0),
       m_peerSelection(PS_RANDOM), m_chunkSelection(CS_LATEST), n_selectionWeight(0), m_delay(0)
 
   {
@@ -223,6 +451,9 @@ namespace ns3
     m_pullRetriesCurrent.clear();
     m_pullTimes.clear();
     m_pullPending.clear();
+    m_pullRttSamples.clear();
+    m_pullHedged.clear();
+    m_pullTried.clear();
     m_duplicates.clear();
     m_chunk_delay.clear();
     m_neighbors.Clear();
@@ -232,6 +463,7 @@ namespace ns3
     m_pullEvent.Cancel();
     m_chunkEvent.Cancel();
     m_pullSlotEvent.Cancel();
+    m_pullHedgeEvent.Cancel();
   }
 
   VideoPushApplication::~VideoPushApplication ()
@@ -278,6 +510,7 @@ namespace ns3
     NS_LOG_FUNCTION_NOARGS ();
     StatisticChunk();
     m_socket = 0;
+    m_unicastPacket = 0;
     m_socketList.clear();
     Application::DoDispose();
   }
@@ -376,7 +609,8 @@ namespace ns3
     delay_max = Time::FromInteger(delaymax, Time::US);
     delay_min = Time::FromInteger(delaymin, Time::US);
     current = received + missed;
-    while ((current = received + missed) < m_latestChunkID)
+    uint32_t latest = m_latestChunk;
+    while ((current = received + missed) < latest)
       missed++;
     double actual = received - missed;
     actual = (actual <= 0 ? 1 : (actual));
@@ -419,12 +653,12 @@ namespace ns3
       }
     else
       {
-        miss = (missed / (1.0 * m_latestChunkID));
-        rec = (received / (1.0 * m_latestChunkID));
+        miss = (missed / (1.0 * latest));
+        rec = (received / (1.0 * latest));
         dups = (duplicates == 0 ? 0 : (1.0 * duplicates) / received);
         dlate = (delayed == 0 ? 0 : delaylate / (1.0 * delayed));
       }
-    NS_ASSERT(m_latestChunkID==received+missed);
+    NS_ASSERT(latest==received+missed);
     double tstudent = 1.96; // alpha = 0.025, degree of freedom = infinite
     double confidence = (sigma == 0 ? 1 : tstudent * (sigma / sqrt(received)));
     double confidenceP = tstudent * (sigmaP / sqrt(receivedpush));
@@ -442,7 +676,7 @@ namespace ns3
         delay_avg_pull = MicroSeconds(0);
       }
     printf(
-        "Chunks Node %d Rec %.5f Miss %.5f Dup %.5f K %d Max %ld us Min %ld us Avg %ld us sigma %.5f conf %.5f late %.5f RecP %d AvgP %ld us sigmaP %.5f confP %.5f RecL %d AvgL %ld us sigmaL %.5f confL %.5f PRec %d PRep %.4f PReq %d PHit %.4f H1 %d H2 %d H3 %d H4 %d H5 %d H6 %d\n",
+        "Chunks Node %d Rec %.5f Miss %.5f Dup %.5f K %d Max %ld us Min %ld us Avg %ld us sigma %.5f conf %.5f late %.5f RecP %d AvgP %ld us sigmaP %.5f confP %.5f RecL %d AvgL %ld us sigmaL %.5f confL %.5f PRec %d PRep %.4f PReq %d PHit %.4f H1 %d H2 %d H3 %d H4 %d H5 %d H6 %d PHed %d PHedDup %d PSup %d PHeld %d POvh %d PCoa %d PDis %d PBud %d GTx %d GRx %d CPull %d CRel %d RTx %d RRx %d NTx %d NRx %d NRetx %d\n",
         m_node->GetId(), rec, miss, dups, received, delay_max.ToInteger(Time::US), delay_min.ToInteger(Time::US),
         delay_avg.ToInteger(Time::US), sigma, confidence, dlate, receivedpush, delay_avg_push.ToInteger(Time::US),
         sigmaP, confidenceP, receivedpull, delay_avg_pull.ToInteger(Time::US), sigmaL, confidenceL,
@@ -450,7 +684,12 @@ namespace ns3
         (m_statisticsPullReceived == 0 ? 0 : m_statisticsPullReply / (1.0 * m_statisticsPullReceived)),
         m_statisticsPullRequest,
         (m_statisticsPullRequest == 0 ? 0 : m_statisticsPullHit / (1.0 * m_statisticsPullRequest)), missing[0],
-        missing[1], missing[2], missing[3], missing[4], missing[5]);
+        missing[1], missing[2], missing[3], missing[4], missing[5], m_statisticsPullHedge, m_statisticsPullHedgeDup,
+        m_statisticsPullSuppressed, m_statisticsPullHeld, m_statisticsPullOverheard,
+        m_statisticsPullCoalesced, m_statisticsPullDiscard,
+        m_statisticsPullNoBudget, m_statisticsGossipTx, m_statisticsGossipRx, m_statisticsClusterPull,
+        m_statisticsClusterRelay, m_statisticsRepairTx, m_statisticsRepairRx,
+        m_statisticsNackTx, m_statisticsNackRx, m_statisticsNackRetx);
   }
 
   uint32_t
@@ -500,12 +739,53 @@ namespace ns3
           }
         m_neighbors.SetExpire(Time::FromDouble(GetHelloTime().GetSeconds() * (1.10 * (1.0 + GetHelloLoss())), Time::S));
         m_neighbors.SetSelectionWeight(n_selectionWeight);
+        m_neighbors.SetBanditDiscount(n_banditDiscount);
         double inter_time = 1 / (m_cbrRate.GetBitRate() / (8.0 * m_pktSize));
         m_pullSlot = Time::FromDouble(inter_time, Time::S);
         m_playout.SetDelay(Time::FromDouble(inter_time, Time::S));
         m_playout.SetFunction(&VideoPushApplication::UpdatePullWBase, this);
+        NS_ASSERT_MSG(m_pullWindowMin <= m_pullWindowMax, "pull window min above max");
         m_pullReplyTimer.SetDelay(m_pullSlot);
         m_pullReplyTimer.SetFunction(&VideoPushApplication::ResetPullReplyCurrent, this);
+        m_pullRate = m_pullRateMax;
+        m_pullReplyBudget.SetRate(m_peerType == SOURCE ? m_sourceReplyRate : m_pullReplyRate);
+        m_pullReplyBudget.SetSize(m_pullReplyBurst);
+        m_pullControlTimer.SetDelay(m_pullControlTime);
+        m_pullControlTimer.SetFunction(&VideoPushApplication::ControlLoop, this);
+        if (m_peerType == PEER && GetPullActive() && !m_pullControlTime.IsZero())
+          m_pullControlTimer.Schedule();
+        m_bufferMapTimer.SetDelay(m_bufferMapTime);
+        m_bufferMapTimer.SetFunction(&VideoPushApplication::SendBufferMap, this);
+        m_meshTimer.SetDelay(m_meshPullTime);
+        m_meshTimer.SetFunction(&VideoPushApplication::MeshLoop, this);
+        m_repairTimer.SetFunction(&VideoPushApplication::RepairLoop, this);
+        NS_ASSERT_MSG(!m_repairPush || !m_bufferMapTime.IsZero(), "repair push needs buffer maps");
+        if (m_peerType == PEER && !m_bufferMapTime.IsZero())
+          m_bufferMapTimer.Schedule(Time::FromDouble(UniformVariable().GetValue(0, m_bufferMapTime.GetSeconds()), Time::S));
+        NS_ASSERT_MSG(m_substream < m_substreams, "substream out of range");
+        m_substreamPush.assign(m_substreams, Seconds(0));
+        m_treeTimer.SetDelay(GetHelloTime());
+        m_treeTimer.SetFunction(&VideoPushApplication::TreeLoop, this);
+        if (m_tree)
+          {
+            m_treeDepth = (m_peerType == SOURCE ? 0 : TREE_DEPTH_INFINITE);
+            m_treeTimer.Schedule(start);
+          }
+        m_nackBudget.SetRate(m_nackRate);
+        m_nackBudget.SetSize(m_nackBurst);
+        m_clusterTimer.SetDelay(GetHelloTime());
+        m_clusterTimer.SetFunction(&VideoPushApplication::ClusterLoop, this);
+        if (m_peerType == PEER && m_cluster)
+          {
+            NS_ASSERT_MSG(GetPullActive() && GetHelloActive(), "cluster heads need pull and hello");
+            m_clusterTimer.Schedule(start + GetHelloTime());
+          }
+        if (m_peerType == PEER && m_meshPull)
+          {
+            NS_ASSERT_MSG(GetPullActive() && GetHelloActive() && !m_bufferMapTime.IsZero(),
+                "mesh pull needs pull, hello and buffer maps");
+            m_meshTimer.Schedule();
+          }
       }
     StartSending();
   }
@@ -569,7 +849,20 @@ namespace ns3
     Simulator::Cancel(m_loopEvent);
     Simulator::Cancel(m_pullEvent);
     Simulator::Cancel(m_pullSlotEvent);
+    Simulator::Cancel(m_pullHedgeEvent);
     Simulator::Cancel(m_chunkEvent);
+    Simulator::Cancel(m_unicastEvent);
+    m_unicastQueue.clear();
+    Simulator::Cancel(m_nackEvent);
+    for (std::list<EventId>::iterator iter = m_gossipEvents.begin(); iter != m_gossipEvents.end(); iter++)
+      Simulator::Cancel(*iter);
+    m_gossipEvents.clear();
+    m_pullControlTimer.Cancel();
+    m_bufferMapTimer.Cancel();
+    m_meshTimer.Cancel();
+    m_treeTimer.Cancel();
+    m_clusterTimer.Cancel();
+    m_repairTimer.Cancel();
   }
 
   void
@@ -584,8 +877,9 @@ namespace ns3
           break;
         }
       case SOURCE:
-        {
-          m_loopEvent = Simulator::ScheduleNow(&VideoPushApplication::PeerLoop, this);
+        { // sources of different substreams push in turn
+          Time offset = Time::FromDouble(m_pullSlot.GetSeconds() * m_substream, Time::S);
+          m_loopEvent = Simulator::Schedule(offset, &VideoPushApplication::PeerLoop, this);
           break;
         }
       }
@@ -699,6 +993,12 @@ namespace ns3
     return m_pullRetriesMax;
   }
 
+  uint32_t
+  VideoPushApplication::GetPullAttemptsMax () const
+  {
+    return m_pullRetriesMax + (m_pullSource ? 1 : 0);
+  }
+
   void
   VideoPushApplication::SetPullWindow (uint32_t window)
   {
@@ -715,9 +1015,56 @@ namespace ns3
   VideoPushApplication::UpdatePullWBase ()
   {
     m_pullWBase++;
+    if (m_pullWindowAdaptive)
+      AdaptPullWindow();
+    /* the slower reply to a hedged pull no longer matters once the chunk left the window */
+    m_pullHedged.erase(m_pullHedged.begin(), m_pullHedged.lower_bound(GetPullWBase()));
     m_playout.Schedule();
   }
 
+  uint32_t
+  VideoPushApplication::GetPullWindowTarget ()
+  {
+    uint32_t base = GetPullWBase();
+    uint32_t last = m_chunks.GetLastChunk();
+    uint32_t burst = 0, run = 0;
+    for (uint32_t i = base; base > 0 && i < (base + GetPullWindow()) && i <= last; i++)
+      {
+        run = (m_chunks.GetChunkState(i) == CHUNK_RECEIVED_PUSH ? 0 : run + 1);
+        burst = (run > burst ? run : burst);
+      }
+    /* A single pull is outstanding at a time, so a burst is repaired in burst round trips.
+     * Twice that leaves room for one retry per chunk. */
+    Time rtt = (GetPullRtt().IsZero() ? GetPullTime() : GetPullRtt());
+    double ticks = rtt.ToDouble(Time::US) / m_playout.GetDelay().ToDouble(Time::US);
+    uint32_t target = (uint32_t) ceil(2.0 * burst * (ticks > 1.0 ? ticks : 1.0));
+    target = (target < m_pullWindowMin ? m_pullWindowMin : target);
+    return (target > m_pullWindowMax ? m_pullWindowMax : target);
+  }
+
+  void
+  VideoPushApplication::AdaptPullWindow ()
+  {
+    uint32_t target = GetPullWindowTarget();
+    uint32_t window = GetPullWindow();
+    if (target < window) // skip one more chunk: less playout delay
+      {
+        SetPullWindow(window - 1);
+        uint32_t passed = m_pullWBase++;
+        if (passed && passed != GetChunkMissed() && !m_chunks.HasChunk(passed)
+            && m_chunks.GetChunkState(passed) == CHUNK_MISSED) // PeerLoop skips the chunk it is pulling
+          SkipChunk(passed);
+      }
+    else if (target > window && m_pullWBase > 1) // hold the base for a tick: more playout delay
+      {
+        SetPullWindow(window + 1);
+        m_pullWBase--;
+      }
+    if (target != window)
+      NS_LOG_DEBUG ("Node " << GetLocalAddress() << " pull window " << window << " -> " << GetPullWindow() << " target " << target
+          << " base " << GetPullWBase());
+  }
+
   void
   VideoPushApplication::SetPullWBase (uint32_t base)
   {
@@ -935,6 +1282,143 @@ namespace ns3
     return m_pullChunkMissed;
   }
 
+  void
+  VideoPushApplication::SkipChunk (uint32_t chunkid)
+  {
+    NS_LOG_FUNCTION(this<<chunkid);
+    NS_ASSERT(m_chunks.GetChunkState(chunkid)==CHUNK_MISSED);
+    m_chunks.SetChunkState(chunkid, CHUNK_SKIPPED); // Mark as skipped
+    m_pullMisses++;
+    NS_ASSERT(m_chunks.GetChunkState(chunkid)==CHUNK_SKIPPED);
+    RemPullTimes(chunkid); // Remove the chunk form PullTimes
+    SetPullTimes(chunkid, Seconds(0));
+    m_pullTried.erase(chunkid);
+    m_pullHeld.erase(chunkid);
+    m_pullHedged.erase(chunkid);
+  }
+
+  bool
+  VideoPushApplication::IsPullInfeasible (uint32_t chunkid)
+  {
+    if (m_chunkSelection != CS_EARLIEST_DEADLINE || GetChunkDeadline(chunkid) > GetPullRtt())
+      return false;
+    NS_LOG_INFO ("Node " << m_node->GetId() << " chunk " << chunkid << " deadline " << GetChunkDeadline(chunkid)
+        << " RTT " << GetPullRtt() << ", a reply cannot arrive before the playout");
+    return true;
+  }
+
+  Time
+  VideoPushApplication::GetChunkDeadline (uint32_t chunkid)
+  {
+    NS_ASSERT(chunkid>0);
+    if (chunkid < GetPullWBase())
+      return Seconds(0);
+    /* the window base moves by one chunk at each playout tick */
+    Time left = (m_playout.IsRunning() ? m_playout.GetDelayLeft() : m_playout.GetDelay());
+    double ticks = chunkid - GetPullWBase();
+    return Time::FromDouble(left.ToDouble(Time::US) + ticks * m_playout.GetDelay().ToDouble(Time::US), Time::US);
+  }
+
+  void
+  VideoPushApplication::ControlLoop ()
+  {
+    NS_LOG_FUNCTION(this);
+    uint32_t requests = m_statisticsPullRequest - m_pullControlRequest;
+    uint32_t hits = m_statisticsPullHit - m_pullControlHit;
+    uint32_t received = m_statisticsPullReceived - m_pullControlReceived;
+    uint32_t replies = m_statisticsPullReply - m_pullControlReply;
+    m_pullControlRequest = m_statisticsPullRequest;
+    m_pullControlHit = m_statisticsPullHit;
+    m_pullControlReceived = m_statisticsPullReceived;
+    m_pullControlReply = m_statisticsPullReply;
+    uint32_t misses = m_pullMisses - m_pullControlMisses;
+    m_pullControlMisses = m_pullMisses;
+    double hitRatio = (requests ? (1.0 * hits) / requests : 1.0);
+    double dropRate = (received > replies ? (1.0 * (received - replies)) / received : 0.0);
+    /* Pulls that mostly fail, or that neighbors cannot serve, waste airtime: shrink the band.
+     * Playout misses while pulls succeed mean the band is too narrow: widen it. */
+    int32_t vote = 0;
+    if (hitRatio < 0.5 || dropRate > 0.5)
+      vote = -1;
+    else if (misses > 0)
+      vote = 1;
+    m_pullControlTrend = (vote == 0 ? 0 : ((vote > 0) == (m_pullControlTrend > 0) ? m_pullControlTrend + vote : vote));
+    NS_LOG_INFO ("Node " << GetLocalAddress() << " pull control hit " << hitRatio << " drop " << dropRate << " misses " << misses
+        << " trend " << m_pullControlTrend << " band [" << GetPullRatioMin() << ":" << GetPullRatioMax() << "]");
+    if (m_pullControlTrend >= (int32_t) m_pullControlHysteresis)
+      {
+        double low = GetPullRatioMin() - m_pullControlStep, high = GetPullRatioMax() + m_pullControlStep;
+        SetPullRatioMin(low < 0.50 ? 0.50 : low);
+        SetPullRatioMax(high > 1.0 ? 1.0 : high);
+        m_pullControlTrend = 0;
+        m_pullStartTrace(GetReceived(CHUNK_RECEIVED_PUSH));
+        NS_LOG_INFO ("Node " << GetLocalAddress() << " widens pull band to [" << GetPullRatioMin() << ":" << GetPullRatioMax() << "]");
+      }
+    else if (-m_pullControlTrend >= (int32_t) m_pullControlHysteresis)
+      {
+        double low = GetPullRatioMin() + m_pullControlStep, high = GetPullRatioMax() - m_pullControlStep;
+        low = (low > 0.90 ? 0.90 : low);
+        high = (high < 0.80 ? 0.80 : high);
+        SetPullRatioMin(low);
+        SetPullRatioMax(high < low ? low : high);
+        m_pullControlTrend = 0;
+        m_pullStopTrace(GetReceived(CHUNK_RECEIVED_PUSH));
+        NS_LOG_INFO ("Node " << GetLocalAddress() << " shrinks pull band to [" << GetPullRatioMin() << ":" << GetPullRatioMax() << "]");
+      }
+    m_pullControlTimer.Schedule();
+  }
+
+  void
+  VideoPushApplication::UpdatePullRtt (Time sample)
+  {
+    double alpha = 0.125; // same smoothing as TCP SRTT
+    if (m_pullRtt.IsZero())
+      m_pullRtt = sample;
+    else
+      m_pullRtt = Time::FromDouble((1 - alpha) * m_pullRtt.ToDouble(Time::US) + alpha * sample.ToDouble(Time::US),
+          Time::US);
+    m_pullRttSamples.push_back(sample);
+    while (m_pullRttSamples.size() > 32)
+      m_pullRttSamples.pop_front();
+    NS_LOG_DEBUG ("Node " << m_node->GetId() << " pull RTT sample " << sample << " smoothed " << m_pullRtt);
+  }
+
+  Time
+  VideoPushApplication::GetPullRtt () const
+  {
+    return m_pullRtt;
+  }
+
+  uint32_t
+  VideoPushApplication::GetChunkWireSize (uint32_t size) const
+  {
+    return size + MSG_CHUNK_SIZE + CHUNK_HEADER_SIZE;
+  }
+
+  Time
+  VideoPushApplication::GetPullRttPercentile (double percentile)
+  {
+    NS_ASSERT(percentile >= 0 && percentile <= 1);
+    if (m_pullRttSamples.empty())
+      return Seconds(0);
+    std::vector<Time> samples(m_pullRttSamples.begin(), m_pullRttSamples.end());
+    std::sort(samples.begin(), samples.end());
+    uint32_t index = (uint32_t) floor(percentile * (samples.size() - 1));
+    return samples[index];
+  }
+
+  Time
+  VideoPushApplication::GetPullBackoff (uint32_t chunkid)
+  {
+    uint32_t attempts = GetPullRetryCurrent(chunkid);
+    if (m_pullBackoff.IsZero() || attempts == 0)
+      return Seconds(0);
+    double limit = m_pullBackoff.ToDouble(Time::US) * pow(2.0, attempts - 1.0);
+    double slack = (GetChunkDeadline(chunkid) - GetPullRtt() - GetPullTime()).ToDouble(Time::US);
+    limit = (limit < slack ? limit : slack);
+    return (limit > 0 ? TransmissionDelay(0, limit, Time::US) : Seconds(0));
+  }
+
   void
   VideoPushApplication::PeerLoop ()
   {
@@ -948,20 +1432,26 @@ namespace ns3
           NS_ASSERT(GetHelloActive());
           NS_ASSERT(!m_pullTimer.IsRunning());
           NS_ASSERT(!m_pullEvent.IsRunning());
+          if (m_pullOutstanding && m_pullHeld.find(m_pullOutstanding) == m_pullHeld.end()) // no reply to the last pull
+            {
+              UpdatePullTimeoutRate(true);
+              UpdatePullRate(true);
+              if (m_pullTarget != Ipv4Address::GetAny() && !m_pullTarget.IsBroadcast())
+                m_neighbors.AddPullOutcome(Neighbor(m_pullTarget, m_localPort), false);
+            }
+          m_pullOutstanding = 0;
+          m_pullTarget = Ipv4Address::GetAny();
           /* There is a missed chunk*/
           while (GetChunkMissed()
-              && (GetPullRetryCurrent(GetChunkMissed()) >= GetPullMax() || GetChunkMissed() < GetPullWBase()))/* Mark chunks as skipped*/
+              && (GetPullRetryCurrent(GetChunkMissed()) >= GetPullAttemptsMax() || GetChunkMissed() < GetPullWBase()
+                  || IsPullInfeasible(GetChunkMissed())))/* Mark chunks as skipped*/
             {
               uint32_t lastmissed = GetChunkMissed();
-              NS_ASSERT(m_chunks.GetChunkState(lastmissed)==CHUNK_MISSED);
-              m_chunks.SetChunkState(lastmissed, CHUNK_SKIPPED); // Mark as skipped
-              NS_ASSERT(m_chunks.GetChunkState(lastmissed)==CHUNK_SKIPPED);
-              RemPullTimes(lastmissed); // Remove the chunk form PullTimes
-              SetPullTimes(lastmissed, Seconds(0));
+              SkipChunk(lastmissed);
               SetChunkMissed(ChunkSelection(m_chunkSelection)); // Update chunk missed
               NS_ASSERT (lastmissed != GetChunkMissed());
               NS_LOG_INFO ("Node " <<m_node->GetId()<< " is marking chunk "<< lastmissed
-                  <<" as skipped ("<<(lastmissed?GetPullRetryCurrent(lastmissed):0)<<"/"<<GetPullMax()<<") New missed="<<GetChunkMissed ());
+                  <<" as skipped ("<<(lastmissed?GetPullRetryCurrent(lastmissed):0)<<"/"<<GetPullAttemptsMax()<<") New missed="<<GetChunkMissed ());
             }
           SetChunkMissed(ChunkSelection(m_chunkSelection));
           NS_LOG_INFO ("Node " << m_node->GetId() << " IP=" << GetLocalAddress()
@@ -969,17 +1459,47 @@ namespace ns3
               << " Last=" << m_chunks.GetLastChunk() << " Missed=" << GetChunkMissed() << " ("<<(GetChunkMissed()?GetPullRetryCurrent(GetChunkMissed()):0)<<","<<GetPullMax()<<")"
               << " Wmin=" << GetPullWBase() <<" Wmax="<< GetPullWindow()+GetPullWBase()
               << " Timer="<<(m_pullTimer.IsRunning()?"Yes":"No"));
-          if (GetChunkMissed() && InPullRange())/*check whether the node is within Pull-allowed range*/
+          if (GetChunkMissed() && InPullRange() && IsPullHeld(GetChunkMissed()))
+            { /* a neighbor has pulled the same chunk, wait for its reply */
+              m_pullOutstanding = GetChunkMissed();
+              m_pullTimer.Schedule(m_pullHeld[GetChunkMissed()] - Simulator::Now());
+              NS_LOG_INFO ("Node " <<m_node->GetId()<< " holds pull for chunk " << GetChunkMissed() << " until "
+                  << m_pullHeld[GetChunkMissed()]);
+            }
+          else if (GetChunkMissed() && InPullRange())/*check whether the node is within Pull-allowed range*/
             {
-              Neighbor target = PeerSelection(m_peerSelection);
+              /* Do not ask again a neighbor that already failed to reply for this chunk,
+               * nor neighbors without upload budget left for a reply */
+              std::set<Ipv4Address> exclude = m_pullTried[GetChunkMissed()];
+              m_neighbors.GetDepleted(GetChunkWireSize(m_pktSize), exclude);
+              if (m_substreams > 1) // neighbors pushed other substreams only likely miss the chunk
+                m_neighbors.GetMissingSubstream(GetChunkMissed() % m_substreams, exclude);
+              Neighbor target = PeerSelection(m_peerSelection, exclude);
+              if (target.GetAddress() == Ipv4Address::GetAny() && !exclude.empty())
+                {
+                  m_pullTried.erase(GetChunkMissed()); // all neighbors tried, start over
+                  target = PeerSelection(m_peerSelection);
+                }
+              uint32_t retries = GetPullRetryCurrent(GetChunkMissed());
+              if (m_clusterHead && retries > 0) // neighbors failed, the whole cell may miss it: ask another cell
+                {
+                  Ipv4Address remote = GetClusterRemote(m_pullTried[GetChunkMissed()]);
+                  if (remote != Ipv4Address::GetAny())
+                    target = Neighbor(remote, m_localPort);
+                }
+              if (m_pullSource && retries >= GetPullMax()) // neighbors failed, one more attempt to the source
+                target = Neighbor(GetSource(), m_localPort);
               m_neighborsTrace(m_neighbors.GetSize());
               NS_ASSERT(!m_pullTimer.IsRunning());
               NS_ASSERT(!m_pullEvent.IsRunning());
               if (target.GetAddress() != Ipv4Address::GetAny())
                 {
-                  NS_ASSERT(m_neighbors.IsNeighbor(target));
-                  Time delay = TransmissionDelay(100, 2000, Time::US); //[0-2000]us random
-                  m_pullTimer.Schedule();
+                  NS_ASSERT(target.GetAddress().IsBroadcast() || target.GetAddress() == GetSource() || m_neighbors.IsNeighbor(target)
+                      || m_clusterRemote.find(target.GetAddress()) != m_clusterRemote.end());
+                  Time backoff = GetPullBackoff(GetChunkMissed()) + GetPullPacing();
+                  Time delay = backoff + PullJitter(100, 2000); //[0-2000]us random, stretched by contention
+                  m_pullTimer.Schedule(backoff + m_pullTimer.GetDelay());
+                  m_pullOutstanding = GetChunkMissed();
                   m_pullEvent = Simulator::Schedule(delay, &VideoPushApplication::SendPull, this, GetChunkMissed(),
                       target.GetAddress());
                   NS_LOG_INFO ("Node " <<m_node->GetId()<< " schedule pull to "<< target.GetAddress()
@@ -1007,7 +1527,7 @@ namespace ns3
             {
               uint32_t bits = m_pktSize * 8 - m_residualBits;
               NS_LOG_LOGIC ("bits = " << bits);
-              Time nextTime(Seconds(bits / static_cast<double>(m_cbrRate.GetBitRate()))); // Time till next packet
+              Time nextTime(Seconds(m_substreams * bits / static_cast<double>(m_cbrRate.GetBitRate()))); // Time till next packet
               m_chunkEvent = Simulator::ScheduleNow(&VideoPushApplication::SendPacket, this);
               m_loopEvent = Simulator::Schedule(nextTime, &VideoPushApplication::PeerLoop, this);
             }
@@ -1026,19 +1546,24 @@ namespace ns3
   }
 
   void
-  VideoPushApplication::HandleChunk (ChunkHeader::ChunkMessage &chunkheader, const Ipv4Address &sender)
+  VideoPushApplication::HandleChunk (ChunkHeader::ChunkMessage &chunkheader, const Ipv4Address &sender, uint8_t flags)
   {
     NS_ASSERT(m_peerType == PEER);
     ChunkVideo chunk = chunkheader.GetChunk();
     m_totalRx += chunk.GetSize() + chunk.GetAttributeSize();
+    m_latestChunk = (chunk.c_id > m_latestChunk ? chunk.c_id : m_latestChunk);
     bool toolate = (m_chunks.GetChunkState(chunk.c_id) == CHUNK_SKIPPED || chunk.c_id < GetPullWBase()); // chunk has been expired
     bool duplicated = m_chunks.HasChunk(chunk.c_id);
     if (duplicated) // Duplicated chunk
       {
         StatisticAddDuplicateChunk(chunk.c_id);
+        if (m_pullHedged.erase(chunk.c_id)) // the slower reply to a hedged pull
+          m_statisticsPullHedgeDup++;
       }
     else if (GetPullRetryCurrent(chunk.c_id) && toolate) // has been pulled and received too late
       {
+        if (m_chunks.GetChunkState(chunk.c_id) != CHUNK_SKIPPED && m_chunks.GetChunkState(chunk.c_id) != CHUNK_DELAYED)
+          m_pullMisses++; // skipped chunks are already counted
         m_chunks.SetChunkState(chunk.c_id, CHUNK_DELAYED);
         NS_LOG_INFO ("Node "<< GetLocalAddress() << " has received too late missed chunk "<< chunk.c_id);NS_LOG_DEBUG ("Node " <<m_node->GetId()<<" PULLEND");
       }
@@ -1046,15 +1571,51 @@ namespace ns3
       {
         Time delay = Simulator::Now() - MicroSeconds(chunk.c_tstamp);
         SetChunkDelay(chunk.c_id, delay);
-        if (GetPullRetryCurrent(chunk.c_id)) // has been pulled and received in time
+        Ipv4Address requester = chunkheader.GetRequester();
+        bool pulled = (requester == GetLocalAddress() || (requester.IsBroadcast() && GetPullRetryCurrent(chunk.c_id)));
+        if (requester != Ipv4Address::GetAny() && !pulled)
+          { // reply to a neighbor's pull, overheard
+            m_chunks.AddChunk(chunk, CHUNK_RECEIVED_PULL);
+            NS_ASSERT(sender != GetSource() || m_nack); // or retransmitted by the source after NACKs
+            if (m_pullOutstanding == chunk.c_id) // own pull pending or held
+              {
+                NS_ASSERT(m_pullTimer.IsRunning());
+                m_pullTimer.Cancel();
+                Simulator::Cancel(m_pullEvent);
+                Simulator::Cancel(m_pullHedgeEvent);
+                m_pullOutstanding = 0;
+              }
+            m_pullHeld.erase(chunk.c_id);
+            m_pullTried.erase(chunk.c_id);
+            m_statisticsPullOverheard++;
+            NS_LOG_INFO ("Node "<< GetLocalAddress() << " has received missed chunk "<< chunk.c_id<< " pulled by "
+                << requester);
+          }
+        else if (GetPullRetryCurrent(chunk.c_id)) // has been pulled and received in time
           {
             m_chunks.AddChunk(chunk, CHUNK_RECEIVED_PULL);
-            NS_ASSERT(sender != GetSource());
-            NS_ASSERT(m_pullTimer.IsRunning());
-            NS_ASSERT(!m_pullEvent.IsRunning());
-            m_pullTimer.Cancel();
+            NS_ASSERT(sender != GetSource() || m_pullSource || m_nack);
+            if (m_pullOutstanding == chunk.c_id) // reply to the pending pull, otherwise a late reply to a previous one
+              {
+                NS_ASSERT(m_pullTimer.IsRunning());
+                m_pullTimer.Cancel();
+                Simulator::Cancel(m_pullEvent); // a broadcast reply may beat the retry still to be sent
+                m_pullOutstanding = 0;
+                UpdatePullTimeoutRate(false);
+                UpdatePullRate(false);
+                m_pullTarget = Ipv4Address::GetAny();
+              }
+            Simulator::Cancel(m_pullHedgeEvent);
+            m_pullHeld.erase(chunk.c_id);
+            m_pullTried.erase(chunk.c_id);
+            m_meshRequested.erase(chunk.c_id);
+            if (m_meshPull && !m_playout.IsRunning()) // first chunk, mesh peers may never get a push
+              SchedulePlayout();
+            m_neighbors.AddPullOutcome(Neighbor(sender, m_localPort), true);
             StatisticAddPullHit();
             Time shift = (Simulator::Now() - GetPullTimes(chunk.c_id));
+            if (GetPullRetryCurrent(chunk.c_id) == 1) // unambiguous sample, a single pull was sent
+              UpdatePullRtt(shift);
             NS_LOG_INFO ("Node "<< GetLocalAddress() << " has received missed chunk "<< chunk.c_id<< " after "
                 << shift.GetSeconds()<< " ~ "<< (shift.GetSeconds()/(1.0*GetPullTime().GetSeconds())));
             /* TODO need min and max values to limit the timeout value.
@@ -1067,16 +1628,28 @@ namespace ns3
           }
         else
           {
-            SetPullSlotStart(Simulator::Now());
-            ResetPullReplyCurrent();
-            if (m_chunks.GetSize() == 1) // this is the first chunk
+            if (sender == GetSource() || sender == m_treeParent || (flags & CHUNK_FLAG_SOURCE)) // the pull slot follows the source push
               {
-                NS_ASSERT(!m_playout.IsRunning());
-                double playtime = ( (8.0 * m_pktSize * GetPullWindow()) / m_cbrRate.GetBitRate() );
-                m_playout.Schedule(Time::FromDouble(playtime, Time::S));
+                SetPullSlotStart(Simulator::Now());
+                ResetPullReplyCurrent();
               }
-            NS_ASSERT(sender == GetSource());
+            else if (flags & CHUNK_FLAG_GOSSIP)
+              m_statisticsGossipRx++;
+            if (m_chunks.GetSize() == 1 && !(m_meshPull && m_playout.IsRunning())) // this is the first chunk
+              SchedulePlayout();
             m_chunks.AddChunk(chunk, CHUNK_RECEIVED_PUSH);
+            m_substreamPush[chunk.c_id % m_substreams] = Simulator::Now();
+            if (m_tree)
+              TreeForward(chunk.c_id, sender);
+            uint8_t ttl = chunkheader.GetTtl();
+            if (m_gossipFanout > 0 && ttl > 0 && UniformVariable().GetValue() < m_gossipProbability)
+              { // forward the first copy only, duplicates are dropped above
+                while (!m_gossipEvents.empty() && !m_gossipEvents.front().IsRunning())
+                  m_gossipEvents.pop_front();
+                Time delay = TransmissionDelay(100, 2000, Time::US);
+                m_gossipEvents.push_back(
+                    Simulator::Schedule(delay, &VideoPushApplication::GossipChunk, this, chunk.c_id, ttl - 1, sender));
+              }
           }
       }
     SetChunkMissed(ChunkSelection(m_chunkSelection));
@@ -1086,7 +1659,8 @@ namespace ns3
         <<" #Neighbors "<< m_neighbors.GetSize()
         <<" Missed="<<GetChunkMissed()<< " Chunks="<<m_chunks.GetBufferSize()
         <<" Slot="<<GetPullSlotStart().GetSeconds());
-    if (GetPullActive() && GetChunkMissed() && !m_pullTimer.IsRunning() && !m_pullEvent.IsRunning() && InPullRange())
+    if (!m_meshPull && GetPullActive() && GetChunkMissed() && !m_pullTimer.IsRunning() && !m_pullEvent.IsRunning()
+        && InPullRange())
       {
         Time delay(0);
         if (GetPullSlotStart() > Simulator::Now())
@@ -1105,10 +1679,11 @@ namespace ns3
     NS_ASSERT(m_chunks.GetLastChunk()>=GetPullWindow());
     if (PullSlot() < PullReqThr)/*Check whether the node is within a pull slot or not*/
       {
-        ChunkHeader pull(MSG_PULL);
-        pull.GetPullMessage().SetChunk(chunkid);
-        Ptr<Packet> packet = Create<Packet>();
-        packet->AddHeader(pull);
+        bool source = (target == GetSource());
+        bool remote = (m_clusterHead && m_clusterRemote.find(target) != m_clusterRemote.end()); // head of another cell
+        uint8_t flags = (source ? PULL_FLAG_SOURCE : (remote ? PULL_FLAG_CLUSTER : (target.IsBroadcast() ? PULL_FLAG_BROADCAST : (m_pullOverhear ? PULL_FLAG_OVERHEAR : 0))));
+        Ptr<Packet> packet = ForgePull(chunkid, target, flags);
+        Ipv4Address destination = (m_pullOverhear && !source && !remote ? GetLocalAddress().GetSubnetDirectedBroadcast(Ipv4Mask("255.0.0.0")) : target);
         NS_LOG_DEBUG ("Node " << GetNode()->GetId() << " sends pull to "<< target << " for chunk "<< chunkid<< " pid "<< packet->GetUid());
         NS_ASSERT(GetPullSlotStart() <= Simulator::Now() && (GetPullSlotStart() + m_pullSlot) > Simulator::Now());
         NS_ASSERT(Simulator::Now() >= GetPullSlotStart());
@@ -1116,24 +1691,85 @@ namespace ns3
         AddPullRetryCurrent(chunkid);
         SetPullTimes(chunkid);
         StatisticAddPullRequest();
+        m_pullLastSent = Simulator::Now();
+        m_pullTarget = target;
         //TODO CHECK too late chunks
         NS_ASSERT(chunkid <= (GetPullWBase()+GetPullWindow()));
-        m_socket->SendTo(packet, 0, InetSocketAddress(target, PUSH_PORT));
+        if (remote)
+          {
+            m_statisticsClusterPull++;
+            ClusterSend(packet, destination);
+          }
+        else
+          m_socket->SendTo(packet, 0, InetSocketAddress(destination, m_localPort));
         m_txControlPullTrace(packet);
+        if (!target.IsBroadcast())
+          m_pullTried[chunkid].insert(target);
+        Time hedge = GetPullRttPercentile(m_pullHedgePercentile);
+        Time deadline = GetChunkDeadline(chunkid);
+        /* hedge when a retry after the timeout would miss the playout, but a second round trip after the hedge delay does not */
+        if (m_pullHedge && !target.IsBroadcast() && !source && !hedge.IsZero() && deadline <= GetPullTime() + GetPullRtt()
+            && deadline > hedge + GetPullRtt())
+          {
+            Simulator::Cancel(m_pullHedgeEvent);
+            m_pullHedgeEvent = Simulator::Schedule(hedge, &VideoPushApplication::SendHedgedPull, this, chunkid, target);
+          }
       }
     else // out of threshold, cancel the PeerLoop
       {
         m_pullTimer.Cancel();
+        m_pullOutstanding = 0;
       }
   }
 
   void
-  VideoPushApplication::HandlePull (ChunkHeader::PullMessage &pullheader, const Ipv4Address &sender)
+  VideoPushApplication::SendHedgedPull (uint32_t chunkid, const Ipv4Address first)
+  {
+    NS_LOG_FUNCTION (this<<chunkid<<first);
+    NS_ASSERT(chunkid>0);
+    if (m_chunks.HasChunk(chunkid) || m_chunks.GetChunkState(chunkid) != CHUNK_MISSED || PullSlot() >= PullReqThr)
+      return;
+    std::set<Ipv4Address> exclude = m_pullTried[chunkid];
+    exclude.insert(first);
+    Neighbor target = PeerSelection(m_peerSelection, exclude);
+    if (target.GetAddress() == Ipv4Address::GetAny())
+      return;
+    Ptr<Packet> packet = ForgePull(chunkid, target.GetAddress(), (m_pullOverhear ? PULL_FLAG_OVERHEAR : 0));
+    Ipv4Address destination = (m_pullOverhear ? GetLocalAddress().GetSubnetDirectedBroadcast(Ipv4Mask("255.0.0.0")) : target.GetAddress());
+    NS_LOG_INFO ("Node " << GetNode()->GetId() << " hedges pull for chunk " << chunkid << " to " << target.GetAddress()
+        << " after no reply from " << first);
+    AddPullRetryCurrent(chunkid); // an attempt as any other pull
+    StatisticAddPullRequest();
+    m_statisticsPullHedge++;
+    m_pullHedged.insert(chunkid);
+    m_pullTried[chunkid].insert(target.GetAddress());
+    m_socket->SendTo(packet, 0, InetSocketAddress(destination, m_localPort));
+    m_txControlPullTrace(packet);
+  }
+
+  void
+  VideoPushApplication::HandlePull (ChunkHeader::PullMessage &pullheader, const Ipv4Address &sender, uint8_t flags)
   {
     switch (m_peerType)
       {
       case SOURCE:
         {
+          uint32_t chunkid = pullheader.GetChunk();
+          StatisticAddPullReceived();
+          if (!(flags & PULL_FLAG_SOURCE) || !m_pullReplyBudget.IsEnabled() || !m_chunks.HasChunk(chunkid))
+            break;
+          uint32_t bytes = GetChunkWireSize(m_chunks.GetChunk(chunkid)->GetSize());
+          if (m_pullReplyBudget.HasTokens(bytes))
+            {
+              NS_LOG_INFO ("Source " << GetLocalAddress() << " Received pull for " << chunkid << " from " << sender << ", reply");
+              SendChunk(chunkid, sender, false);
+            }
+          else
+            {
+              m_statisticsPullNoBudget++;
+              NS_LOG_INFO ("Source " << GetLocalAddress() << " Received pull for " << chunkid << " from " << sender
+                  << " NO reply, budget " << m_pullReplyBudget.GetTokens() << " bytes");
+            }
           break;
         }
       case PEER:
@@ -1143,15 +1779,62 @@ namespace ns3
           uint32_t chunkid = pullheader.GetChunk();
           Time now = Simulator::Now();
           bool hasChunk = m_chunks.HasChunk(chunkid);
-          Time delay = TransmissionDelay(100, 1500, Time::US);
+          bool suppress = (m_pullReplySuppression && (flags & PULL_FLAG_BROADCAST));
+          Time delay = (suppress ? SuppressionDelay(sender) : PullJitter(100, 1500));
           StatisticAddPullReceived();
-          if (hasChunk && !m_chunkEvent.IsRunning() && GetPullReplyCurrent() <= GetPullReplyMax()
+          bool coalesce = !m_pullReplyAggregation.IsZero();
+          bool pending = (coalesce && m_chunkEvent.IsRunning() && m_pullReplyChunk == chunkid && m_pullReplyTarget != sender);
+          uint32_t bytes = (hasChunk ? GetChunkWireSize(m_chunks.GetChunk(chunkid)->GetSize()) : 0);
+          /* Time to serve the pull: reply wait plus reply transmission, our own pull RTT says nothing about the link */
+          Time service = Seconds(bytes * 8 / static_cast<double>(m_cbrRate.GetBitRate()))
+              + (pending ? Simulator::GetDelayLeft(m_chunkEvent) : (coalesce ? delay + m_pullReplyAggregation : delay));
+          if (flags & PULL_FLAG_MESH) // pulls scheduled from buffer maps come in batches, queue them
+            {
+              if (hasChunk && m_meshReplies.size() < GetPullWindow())
+                {
+                  m_meshReplies.push_back(std::make_pair(chunkid, sender));
+                  if (!m_chunkEvent.IsRunning())
+                    m_chunkEvent = Simulator::Schedule(delay, &VideoPushApplication::SendMeshReply, this);
+                  NS_LOG_INFO ("Node " << GetLocalAddress() << " Received mesh pull for " << chunkid << " from " << sender
+                      << ", queued " << m_meshReplies.size());
+                }
+              else
+                NS_LOG_INFO ("Node " << GetLocalAddress() << " Received mesh pull for " << chunkid << " from " << sender << " NO reply");
+            }
+          else if (hasChunk && !pending && !m_pullReplyBudget.HasTokens(bytes))
+            {
+              m_statisticsPullNoBudget++;
+              NS_LOG_INFO ("Node " << GetLocalAddress() << " Received pull for " << chunkid << " from " << sender
+                  << " NO reply, budget " << m_pullReplyBudget.GetTokens() << " bytes");
+            }
+          else if (hasChunk && pullheader.GetDeadline() && service > MicroSeconds(pullheader.GetDeadline()))
+            {
+              m_statisticsPullDiscard++;
+              NS_LOG_INFO ("Node " << GetLocalAddress() << " Received pull for " << chunkid << " from " << sender
+                  << " NO reply, deadline " << pullheader.GetDeadline() << "us service " << service.GetMicroSeconds() << "us");
+            }
+          else if (pending)
+            { // another neighbor asks for the chunk already scheduled, serve both with one reply
+              AddPending(chunkid);
+              NS_LOG_INFO ("Node " << GetLocalAddress() << " Received pull for " << chunkid << " from " << sender
+                  << ", coalesced with " << GetPending(chunkid) - 1 << " pending");
+            }
+          else if (hasChunk && !m_chunkEvent.IsRunning() && GetPullReplyCurrent() <= GetPullReplyMax()
               && PullSlot() < PullRepThr)
             {
               NS_LOG_DEBUG(GetPullSlotStart().GetMicroSeconds()<<" < " << now.GetMicroSeconds() << " < " << GetPullSlotEnd().GetMicroSeconds() << " : "<< (GetPullSlotEnd()-Simulator::Now()).GetMicroSeconds());
               NS_ASSERT(now >= GetPullSlotStart());
               NS_ASSERT(now <= GetPullSlotEnd());
-              m_chunkEvent = Simulator::Schedule(delay, &VideoPushApplication::SendChunk, this, chunkid, sender);
+              if (coalesce) // wait for other neighbors missing the same chunk
+                {
+                  delay = delay + m_pullReplyAggregation;
+                  RemovePending(chunkid);
+                  AddPending(chunkid);
+                }
+              bool broadcast = (suppress || (flags & PULL_FLAG_OVERHEAR));
+              m_chunkEvent = Simulator::Schedule(delay, &VideoPushApplication::SendChunk, this, chunkid, sender, broadcast);
+              m_pullReplyChunk = chunkid;
+              m_pullReplyTarget = sender;
               NS_LOG_INFO ("Node " << GetLocalAddress() << " Received pull for " << chunkid << " from " << sender << ", reply in "<<delay.GetSeconds());
             }
           else
@@ -1166,34 +1849,150 @@ namespace ns3
       }
   }
 
+  Time
+  VideoPushApplication::SuppressionDelay (const Ipv4Address &sender)
+  {
+    /* Neighbors with the best link to the requester draw from the first half of the
+     * reply window, the others are pushed towards its end and are likely to overhear
+     * a reply before their own timer fires.*/
+    double l = 100, u = 100 + 1400 * GetPullJitterScale();
+    double quality = m_neighbors.GetLinkQuality(Neighbor(sender, m_localPort));
+    double low = l + (1.0 - quality) * (u - l) / 2.0;
+    return TransmissionDelay(low, low + (u - l) / 2.0, Time::US);
+  }
+
+  void
+  VideoPushApplication::HandleOverheardChunk (ChunkHeader::ChunkMessage &chunkheader, const Ipv4Address &sender)
+  {
+    uint32_t chunkid = chunkheader.GetChunk().c_id;
+    Ipv4Address requester = chunkheader.GetRequester();
+    NS_LOG_DEBUG ("Node " << GetLocalAddress() << " overhears reply for chunk " << chunkid << " from " << sender
+        << " to " << requester);
+    if (m_chunkEvent.IsRunning() && m_pullReplyChunk == chunkid && m_pullReplyTarget == requester)
+      {
+        Simulator::Cancel(m_chunkEvent);
+        RemovePending(chunkid);
+        m_statisticsPullSuppressed++;
+        NS_LOG_INFO ("Node " << GetLocalAddress() << " suppresses its reply for chunk " << chunkid << " to " << requester
+            << ", already sent by " << sender);
+      }
+    if ((m_pullOverhear || (m_cluster && requester.IsBroadcast())) && m_playout.IsRunning() && !m_chunks.HasChunk(chunkid) && chunkid >= GetPullWBase()
+        && m_chunks.GetChunkState(chunkid) != CHUNK_SKIPPED)
+      HandleChunk(chunkheader, sender, 0);
+  }
+
+  void
+  VideoPushApplication::HandleOverheardPull (ChunkHeader::PullMessage &pullheader, const Ipv4Address &sender)
+  {
+    uint32_t chunkid = pullheader.GetChunk();
+    if (!m_pullOverhear || !m_playout.IsRunning() || m_chunks.HasChunk(chunkid) || chunkid < GetPullWBase()
+        || m_chunks.GetChunkState(chunkid) == CHUNK_SKIPPED || IsPullHeld(chunkid))
+      return;
+    m_pullHeld[chunkid] = Simulator::Now() + GetPullTime();
+    m_statisticsPullHeld++;
+    NS_LOG_INFO ("Node " << GetLocalAddress() << " overhears pull for chunk " << chunkid << " from " << sender
+        << " to " << pullheader.GetTarget() << ", holding own pull");
+    if (m_pullOutstanding == chunkid && m_pullEvent.IsRunning()) // own pull not sent yet
+      Simulator::Cancel(m_pullEvent);
+  }
+
+  bool
+  VideoPushApplication::IsPullHeld (uint32_t chunkid)
+  {
+    std::map<uint32_t, Time>::iterator held = m_pullHeld.find(chunkid);
+    if (held == m_pullHeld.end())
+      return false;
+    if (held->second <= Simulator::Now())
+      {
+        m_pullHeld.erase(held);
+        return false;
+      }
+    return true;
+  }
+
+  void
+  VideoPushApplication::GossipChunk (uint32_t chunkid, uint8_t ttl, const Ipv4Address sender)
+  {
+    NS_LOG_FUNCTION (this<<chunkid<<(uint32_t)ttl<<sender);
+    NS_ASSERT(m_peerType == PEER);
+    NS_ASSERT(m_chunks.HasChunk(chunkid));
+    std::set<Ipv4Address> exclude;
+    exclude.insert(sender);
+    exclude.insert(GetSource());
+    ChunkVideo *copy = m_chunks.GetChunk(chunkid);
+    for (uint32_t i = 0; i < m_gossipFanout; i++)
+      {
+        Neighbor target = m_neighbors.SelectPeerByRandom(exclude);
+        if (target.GetAddress() == Ipv4Address::GetAny())
+          break;
+        exclude.insert(target.GetAddress());
+        ChunkHeader chunk(MSG_CHUNK);
+        chunk.SetStream(m_stream);
+        chunk.SetReserved(CHUNK_FLAG_GOSSIP);
+        chunk.GetChunkMessage().SetChunk(*copy);
+        chunk.GetChunkMessage().SetTtl(ttl);
+        Ptr<Packet> packet = Create<Packet>(copy->GetSize());
+        packet->AddHeader(chunk);
+        NS_LOG_LOGIC ("Node " << GetLocalAddress() << " gossips chunk [" << *copy << "] to " << target.GetAddress()
+            << " TTL " << (uint32_t) ttl << " UID "<< packet->GetUid());
+        m_statisticsGossipTx++;
+        m_txDataTrace(packet);
+        m_socket->SendTo(packet, 0, InetSocketAddress(target.GetAddress(), m_localPort));
+      }
+  }
+
   void
-  VideoPushApplication::SendChunk (uint32_t chunkid, const Ipv4Address target)
+  VideoPushApplication::SendChunk (uint32_t chunkid, const Ipv4Address target, bool broadcast)
   {
-    NS_LOG_FUNCTION (this<<chunkid<<target);
+    NS_LOG_FUNCTION (this<<chunkid<<target<<broadcast);
     NS_ASSERT(chunkid>0);
     NS_ASSERT(target != GetLocalAddress());
-    NS_ASSERT(GetPullActive());
-    NS_ASSERT(GetHelloActive());
     switch (m_peerType)
       {
       case PEER:
         {
+          NS_ASSERT(GetPullActive());
+          NS_ASSERT(GetHelloActive());
           NS_ASSERT(!m_chunkEvent.IsRunning());
           ChunkHeader chunk(MSG_CHUNK);
+          chunk.SetStream(m_stream);
           ChunkVideo *copy = m_chunks.GetChunk(chunkid);
           Ptr<Packet> packet = Create<Packet>(copy->GetSize());
+          uint32_t requesters = GetPending(chunkid);
+          RemovePending(chunkid);
+          if (requesters > 1) // one reply for all the pending pulls
+            {
+              m_statisticsPullCoalesced += requesters - 1;
+              broadcast = true;
+            }
           chunk.GetChunkMessage().SetChunk(*copy);
+          chunk.GetChunkMessage().SetRequester(requesters > 1 ? Ipv4Address::GetBroadcast() : target);
           packet->AddHeader(chunk);
-          NS_LOG_LOGIC ("Node " << GetLocalAddress() << " replies pull to " << target << " for chunk [" << *copy<< "] Size " << packet->GetSize() << " UID "<< packet->GetUid());
+          Ipv4Mask mask("255.0.0.0");
+          Ipv4Address destination = (broadcast ? GetLocalAddress().GetSubnetDirectedBroadcast(mask) : target);
+          NS_LOG_LOGIC ("Node " << GetLocalAddress() << " replies pull to " << target << " via " << destination << " for chunk [" << *copy<< "] Size " << packet->GetSize() << " UID "<< packet->GetUid());
           StatisticAddPullReply();
           AddPullReplyCurrent();
+          m_pullReplyBudget.Consume(GetChunkWireSize(copy->GetSize()));
           m_txDataPullTrace(packet);
-          m_socket->SendTo(packet, 0, InetSocketAddress(target, PUSH_PORT));
+          m_socket->SendTo(packet, 0, InetSocketAddress(destination, m_localPort));
           break;
         }
       case SOURCE:
-        {
-          NS_ASSERT_MSG(false, "source cannot reply to pull");
+        { // last resort reply, the multicast push is not affected
+          NS_ASSERT(m_pullReplyBudget.IsEnabled());
+          ChunkHeader chunk(MSG_CHUNK);
+          chunk.SetStream(m_stream);
+          ChunkVideo *copy = m_chunks.GetChunk(chunkid);
+          Ptr<Packet> packet = Create<Packet>(copy->GetSize());
+          chunk.GetChunkMessage().SetChunk(*copy);
+          chunk.GetChunkMessage().SetRequester(target);
+          packet->AddHeader(chunk);
+          NS_LOG_LOGIC ("Source " << GetLocalAddress() << " replies pull to " << target << " for chunk [" << *copy<< "] Size " << packet->GetSize() << " UID "<< packet->GetUid());
+          StatisticAddPullReply();
+          m_pullReplyBudget.Consume(GetChunkWireSize(copy->GetSize()));
+          m_txDataPullTrace(packet);
+          m_socket->SendTo(packet, 0, InetSocketAddress(target, m_localPort));
           break;
         }
       default:
@@ -1211,19 +2010,31 @@ namespace ns3
       {
       case SOURCE:
         {
+          std::map<Ipv4Address, uint32_t>::iterator sub = m_subscribers.find(sender);
+          if (sub != m_subscribers.end())
+            sub->second = helloheader.GetLastChunk();
+          if (m_sourceSeeds == 0)
+            break;
+          Neighbor nt(sender, m_localPort);
+          if (!m_neighbors.IsNeighbor(nt))
+            m_neighbors.AddNeighbor(nt);
+          m_neighbors.GetNeighbor(nt)->SetLastContact(Simulator::Now());
           break;
         }
       case PEER:
         {
           uint32_t n_last = helloheader.GetLastChunk();
           uint32_t n_chunks = helloheader.GetChunksReceived();
+          m_latestChunk = (n_last > m_latestChunk ? n_last : m_latestChunk); // chunks the node never got count as missed
           double n_ratio = (helloheader.GetChunksRatio() / 1000.0);
           Ipv4Mask mask("255.0.0.0");
           NS_LOG_DEBUG ("Node " << GetLocalAddress() << " receives broadcast hello from " << sender << " #Chunks="<< n_chunks << " Ratio="<< n_ratio);
-          Neighbor nt(sender, PUSH_PORT);
+          Neighbor nt(sender, m_localPort);
           if (m_neighbors.IsNeighbor(nt))
             {
-              m_neighbors.GetNeighbor(nt)->Update(n_last, n_chunks, n_ratio);
+              m_neighbors.GetNeighbor(nt)->Update(n_chunks, n_last, n_ratio);
+              m_neighbors.GetNeighbor(nt)->SetReplyBudget(helloheader.GetReplyBudget());
+              m_neighbors.GetNeighbor(nt)->SetSubstreams(helloheader.GetSubstreams());
               m_neighbors.ClearNeighborhood();
             }
           break;
@@ -1242,7 +2053,44 @@ namespace ns3
     switch (m_peerType)
       {
       case SOURCE:
-        {
+        { // only pulls sent to the source as last resort are parsed
+          Ptr<Packet> packet;
+          Address from;
+          while ((packet = socket->RecvFrom(from)))
+            {
+              if (packet->GetSize() == 0 || !InetSocketAddress::IsMatchingType(from))
+                break;
+              InetSocketAddress address = InetSocketAddress::ConvertFrom(from);
+              ChunkHeader chunkH(MSG_CHUNK);
+              packet->RemoveHeader(chunkH);
+              if (chunkH.GetStream() != m_stream) // stray packet of another channel
+                continue;
+              if (chunkH.GetType() == MSG_PULL && (chunkH.GetReserved() & PULL_FLAG_SOURCE))
+                {
+                  m_rxControlPullTrace(packet, address);
+                  HandlePull(chunkH.GetPullMessage(), address.GetIpv4(), chunkH.GetReserved());
+                }
+              else if (chunkH.GetType() == MSG_HELLO && (m_sourceSeeds > 0 || m_unicast)) // learn the neighbors to seed, the subscribers' lag
+                {
+                  m_rxControlTrace(packet, address);
+                  HandleHello(chunkH.GetHelloMessage(), address.GetIpv4());
+                }
+              else if (chunkH.GetType() == MSG_TREE && m_tree)
+                {
+                  m_rxControlTrace(packet, address);
+                  HandleTree(chunkH.GetTreeMessage(), address.GetIpv4());
+                }
+              else if (chunkH.GetType() == MSG_CLUSTER && m_cluster)
+                {
+                  m_rxControlTrace(packet, address);
+                  HandleCluster(chunkH.GetClusterMessage(), address.GetIpv4());
+                }
+              else if (chunkH.GetType() == MSG_NACK && m_nack)
+                {
+                  m_rxControlTrace(packet, address);
+                  HandleNack(chunkH.GetNackMessage(), address.GetIpv4());
+                }
+            }
           break;
         }
       case PEER:
@@ -1278,26 +2126,61 @@ namespace ns3
                 {
                   ChunkHeader chunkH(MSG_CHUNK);
                   packet->RemoveHeader(chunkH);
+                  if (chunkH.GetStream() != m_stream) // stray packet of another channel
+                    continue;
                   switch (chunkH.GetType())
                     {
                     case MSG_CHUNK:
                       {
-                        if (sourceAddr == GetSource())
+                        Ipv4Address requester = chunkH.GetChunkMessage().GetRequester();
+                        bool pulled = (requester == GetLocalAddress()
+                            || (requester.IsBroadcast() && GetPullRetryCurrent(chunkH.GetChunkMessage().GetChunk().c_id)));
+                        if (requester != Ipv4Address::GetAny())
+                          m_repairQueue.erase(chunkH.GetChunkMessage().GetChunk().c_id); // a neighbor already served it
+                        if (chunkH.GetReserved() & CHUNK_FLAG_REPAIR)
+                          {
+                            uint32_t chunkid = chunkH.GetChunkMessage().GetChunk().c_id;
+                            m_rxDataPullTrace(packet, address);
+                            if (!m_playout.IsRunning() || chunkid < GetPullWBase() || m_chunks.GetChunkState(chunkid) == CHUNK_SKIPPED)
+                              break;
+                            m_statisticsRepairRx += (m_chunks.HasChunk(chunkid) ? 0 : 1);
+                            HandleChunk(chunkH.GetChunkMessage(), sourceAddr, chunkH.GetReserved());
+                            break;
+                          }
+                        if (requester != Ipv4Address::GetAny() && !pulled)
+                          {
+                            HandleOverheardChunk(chunkH.GetChunkMessage(), sourceAddr);
+                            break;
+                          }
+                        if (requester == Ipv4Address::GetAny()) // pushed by the source or forwarded in gossip
                           {
                             m_rxDataTrace(packet, address);
+                            if (m_nack)
+                              ScheduleNack(chunkH.GetChunkMessage().GetChunk().c_id);
                           }
                         else
                           {
                             m_rxDataPullTrace(packet, address);
                           }
-                        HandleChunk(chunkH.GetChunkMessage(), sourceAddr);
+                        uint32_t chunkid = chunkH.GetChunkMessage().GetChunk().c_id;
+                        bool fresh = !m_chunks.HasChunk(chunkid);
+                        HandleChunk(chunkH.GetChunkMessage(), sourceAddr, chunkH.GetReserved());
+                        if (fresh && m_clusterHead && requester == GetLocalAddress()
+                            && m_clusterRemote.find(sourceAddr) != m_clusterRemote.end() && m_chunks.HasChunk(chunkid))
+                          ClusterRelay(chunkid); // the whole cell likely misses it
                         break;
                       }
                     case MSG_PULL:
                       {
                         NS_ASSERT(GetPullActive());
                         m_rxControlPullTrace(packet, address);
-                        HandlePull(chunkH.GetPullMessage(), sourceAddr);
+                        Ipv4Address target = chunkH.GetPullMessage().GetTarget();
+                        if (chunkH.GetReserved() & PULL_FLAG_CLUSTER)
+                          SendClusterChunk(chunkH.GetPullMessage().GetChunk(), sourceAddr);
+                        else if ((chunkH.GetReserved() & PULL_FLAG_OVERHEAR) && target != GetLocalAddress())
+                          HandleOverheardPull(chunkH.GetPullMessage(), sourceAddr);
+                        else
+                          HandlePull(chunkH.GetPullMessage(), sourceAddr, chunkH.GetReserved());
                         break;
                       }
                     case MSG_HELLO:
@@ -1316,6 +2199,31 @@ namespace ns3
                         HandleHello(chunkH.GetHelloMessage(), sourceAddr);
                         break;
                       }
+                    case MSG_BUFFERMAP:
+                      {
+                        m_rxControlTrace(packet, address);
+                        HandleBufferMap(chunkH.GetBufferMapMessage(), sourceAddr);
+                        break;
+                      }
+                    case MSG_TREE:
+                      {
+                        m_rxControlTrace(packet, address);
+                        if (m_tree)
+                          HandleTree(chunkH.GetTreeMessage(), sourceAddr);
+                        break;
+                      }
+                    case MSG_CLUSTER:
+                      {
+                        m_rxControlTrace(packet, address);
+                        if (m_cluster)
+                          HandleCluster(chunkH.GetClusterMessage(), sourceAddr);
+                        break;
+                      }
+                    case MSG_NACK: // addressed to the source only
+                      {
+                        m_rxControlTrace(packet, address);
+                        break;
+                      }
                     }
                 }
             }
@@ -1371,12 +2279,21 @@ namespace ns3
     return (m_pullPending.find(chunkid)->second > 0);
   }
 
-  bool
-  VideoPushApplication::RemovePending (uint32_t chunkid)
+  uint32_t
+  VideoPushApplication::GetPending (uint32_t chunkid)
   {
+    NS_ASSERT(chunkid >0);
     if (m_pullPending.find(chunkid) == m_pullPending.end())
-      return false;
-    m_pullPending.erase(chunkid);
+      return 0;
+    return m_pullPending.find(chunkid)->second;
+  }
+
+  bool
+  VideoPushApplication::RemovePending (uint32_t chunkid)
+  {
+    if (m_pullPending.find(chunkid) == m_pullPending.end())
+      return false;
+    m_pullPending.erase(chunkid);
     NS_ASSERT(m_pullPending.find(chunkid) == m_pullPending.end());
     return true;
   }
@@ -1394,6 +2311,33 @@ namespace ns3
     return m_source;
   }
 
+  void
+  VideoPushApplication::AddSubscriber (Ipv4Address subscriber)
+  {
+    NS_LOG_FUNCTION (this << subscriber);
+    if (m_subscribers.find(subscriber) == m_subscribers.end())
+      m_subscribers[subscriber] = 0;
+  }
+
+  void
+  VideoPushApplication::RemoveSubscriber (Ipv4Address subscriber)
+  {
+    NS_LOG_FUNCTION (this << subscriber);
+    m_subscribers.erase(subscriber);
+    m_unicastQueue.remove(subscriber);
+    if (m_unicastQueue.empty())
+      Simulator::Cancel(m_unicastEvent);
+  }
+
+  std::set<Ipv4Address>
+  VideoPushApplication::GetSubscribers () const
+  {
+    std::set<Ipv4Address> subscribers;
+    for (std::map<Ipv4Address, uint32_t>::const_iterator iter = m_subscribers.begin(); iter != m_subscribers.end(); iter++)
+      subscribers.insert(iter->first);
+    return subscribers;
+  }
+
   void
   VideoPushApplication::AddPullRetryCurrent (uint32_t chunkid)
   {
@@ -1440,16 +2384,41 @@ namespace ns3
     return m_neighbors.SelectNeighbor(policy);
   }
 
+  Neighbor
+  VideoPushApplication::PeerSelection (PeerPolicy policy, const std::set<Ipv4Address> &exclude)
+  {
+    NS_LOG_FUNCTION (this);
+    return m_neighbors.SelectNeighbor(policy, exclude);
+  }
+
   ChunkVideo
   VideoPushApplication::ForgeChunk ()
   {
     uint64_t tstamp = Simulator::Now().ToInteger(Time::US);
-    if (m_chunks.GetBufferSize() == 0)
-      m_latestChunkID = 0;
-    ChunkVideo cv(++m_latestChunkID, tstamp, m_pktSize, 0);
+    /* the source forges the ids of its substream only */
+    uint32_t last = m_chunks.GetLastChunk();
+    uint32_t chunkid = (last ? last + m_substreams : (m_substream ? m_substream : m_substreams)); // ids are never zero
+    m_latestChunk = (chunkid > m_latestChunk ? chunkid : m_latestChunk);
+    ChunkVideo cv(chunkid, tstamp, m_pktSize, 0);
     return cv;
   }
 
+  Ptr<Packet>
+  VideoPushApplication::ForgePull (uint32_t chunkid, const Ipv4Address target, uint8_t flags)
+  {
+    ChunkHeader pull(MSG_PULL);
+    pull.SetStream(m_stream);
+    pull.SetReserved(flags);
+    pull.GetPullMessage().SetChunk(chunkid);
+    if (!target.IsBroadcast())
+      pull.GetPullMessage().SetTarget(target);
+    uint32_t deadline = GetChunkDeadline(chunkid).GetMicroSeconds();
+    pull.GetPullMessage().SetDeadline(deadline ? deadline : 1); // zero would mean no deadline
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(pull);
+    return packet;
+  }
+
   uint32_t
   VideoPushApplication::ChunkSelection (ChunkPolicy policy)
   {
@@ -1482,6 +2451,45 @@ namespace ns3
           NS_ASSERT(!chunkid||(chunkid>=GetPullWBase() && chunkid<=(GetPullWBase()+GetPullWindow())));
           break;
         }
+      case CS_LEAST_USEFUL:
+        {
+          uint32_t base = (GetPullWBase() < 1 ? 1 : GetPullWBase());
+          uint32_t last = (GetPullWBase() + GetPullWindow() < m_chunks.GetLastChunk() ? GetPullWBase() + GetPullWindow()
+              : m_chunks.GetLastChunk());
+          double rarest = 0.0;
+          for (uint32_t missed = base; missed <= last; missed++)
+            {
+              if (m_chunks.HasChunk(missed) || m_chunks.GetChunkState(missed) != CHUNK_MISSED)
+                continue;
+              double holders = m_neighbors.GetChunkAvailability(missed);
+              if (holders > 0 && (!chunkid || holders < rarest))
+                {
+                  chunkid = missed;
+                  rarest = holders;
+                }
+            }
+          if (!chunkid) // nobody is known to hold a missing chunk, fall back to the least missed
+            chunkid = m_chunks.GetLeastMissed(GetPullWBase(), GetPullWindow());
+          NS_LOG_DEBUG ("Node " << m_node->GetId() << " rarest chunk " << chunkid << " held by " << rarest);
+          NS_ASSERT(!chunkid||!m_chunks.HasChunk(chunkid));
+          NS_ASSERT(!chunkid||m_chunks.GetChunkState(chunkid)==CHUNK_MISSED);
+          NS_ASSERT(!chunkid||(chunkid>=GetPullWBase() && chunkid<=(GetPullWBase()+GetPullWindow())));
+          break;
+        }
+      case CS_EARLIEST_DEADLINE:
+        {
+          uint32_t base = (GetPullWBase() < 1 ? 1 : GetPullWBase());
+          uint32_t last = (GetPullWBase() + GetPullWindow() < m_chunks.GetLastChunk() ? GetPullWBase() + GetPullWindow()
+              : m_chunks.GetLastChunk());
+          for (uint32_t missed = base; !chunkid && missed <= last; missed++)
+            { // infeasible chunks are returned too, PeerLoop skips them
+              if (m_chunks.HasChunk(missed) || m_chunks.GetChunkState(missed) != CHUNK_MISSED)
+                continue;
+              chunkid = missed;
+            }
+          NS_ASSERT(!chunkid||m_chunks.GetChunkState(chunkid)==CHUNK_MISSED);
+          break;
+        }
       case CS_LATEST:
         {
           chunkid = m_chunks.GetLastChunk();
@@ -1513,12 +2521,38 @@ namespace ns3
           uint32_t new_chunk = ChunkSelection(CS_NEW_CHUNK);
           ChunkVideo *copy = m_chunks.GetChunk(new_chunk);
           ChunkHeader chunk(MSG_CHUNK);
+          chunk.SetStream(m_stream);
+          chunk.SetReserved(CHUNK_FLAG_SOURCE);
           chunk.GetChunkMessage().SetChunk(*copy);
+          chunk.GetChunkMessage().SetTtl(m_gossipTtl);
           Ptr<Packet> packet = Create<Packet>(m_pktSize); //TODO You can add here the real chunk data
           packet->AddHeader(chunk);
           uint32_t payload = copy->c_size + copy->c_attributes_size; //data and attributes already in chunk header;
           m_txDataTrace(packet);
-          m_socket->SendTo(packet, 0, m_peer);
+          if (m_tree) // push down the tree overlay
+            {
+              for (std::set<Ipv4Address>::iterator iter = m_treeChildren.begin(); iter != m_treeChildren.end(); iter++)
+                m_socket->SendTo(packet->Copy(), 0, InetSocketAddress(*iter, m_localPort));
+            }
+          else if (m_sourceSeeds > 0) // mesh: seed a few neighbors, the others pull
+            {
+              std::set<Ipv4Address> exclude;
+              for (uint32_t i = 0; i < m_sourceSeeds; i++)
+                {
+                  Neighbor seed = m_neighbors.SelectPeerByRandom(exclude);
+                  if (seed.GetAddress() == Ipv4Address::GetAny())
+                    break;
+                  exclude.insert(seed.GetAddress());
+                  m_socket->SendTo(packet->Copy(), 0, InetSocketAddress(seed.GetAddress(), m_localPort));
+                }
+            }
+          else if (m_unicast) // fan out to the subscribers
+            {
+              Time interval = Seconds(m_substreams * m_pktSize * 8 / static_cast<double>(m_cbrRate.GetBitRate()));
+              UnicastChunk(packet, new_chunk, interval);
+            }
+          else
+            m_socket->SendTo(packet, 0, m_peer);
           m_totBytes += payload;
           m_lastStartTime = Simulator::Now();
           m_residualBits = 0;
@@ -1536,6 +2570,41 @@ namespace ns3
       }
   }
 
+  void
+  VideoPushApplication::UnicastChunk (Ptr<Packet> packet, uint32_t chunkid, Time interval)
+  {
+    NS_LOG_FUNCTION (this << chunkid);
+    NS_ASSERT(m_peerType == SOURCE && m_unicast);
+    while (!m_unicastQueue.empty()) // the previous chunk is late, flush it before swapping the packet
+      {
+        Simulator::Cancel(m_unicastEvent);
+        SendUnicast();
+      }
+    m_unicastPacket = packet;
+    std::multimap<uint32_t, Ipv4Address> lags;
+    for (std::map<Ipv4Address, uint32_t>::iterator iter = m_subscribers.begin(); iter != m_subscribers.end(); iter++)
+      lags.insert(std::make_pair(chunkid > iter->second ? chunkid - iter->second : 0, iter->first));
+    for (std::multimap<uint32_t, Ipv4Address>::reverse_iterator iter = lags.rbegin(); iter != lags.rend(); iter++)
+      m_unicastQueue.push_back(iter->second);
+    if (m_unicastQueue.empty())
+      return;
+    m_unicastGap = Time::FromDouble(interval.GetSeconds() / m_unicastQueue.size(), Time::S);
+    SendUnicast();
+  }
+
+  void
+  VideoPushApplication::SendUnicast ()
+  {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT(!m_unicastQueue.empty() && m_unicastPacket);
+    Ipv4Address subscriber = m_unicastQueue.front();
+    m_unicastQueue.pop_front();
+    NS_LOG_DEBUG ("Source " << GetLocalAddress() << " pushes to subscriber " << subscriber << ", left " << m_unicastQueue.size());
+    m_socket->SendTo(m_unicastPacket->Copy(), 0, InetSocketAddress(subscriber, m_localPort));
+    if (!m_unicastQueue.empty())
+      m_unicastEvent = Simulator::Schedule(m_unicastGap, &VideoPushApplication::SendUnicast, this);
+  }
+
   void
   VideoPushApplication::SendHello ()
   {
@@ -1552,18 +2621,24 @@ namespace ns3
           Ipv4Mask mask("255.0.0.0");
           Ipv4Address subnet = GetLocalAddress().GetSubnetDirectedBroadcast(Ipv4Mask(mask));
           ChunkHeader hello(MSG_HELLO);
+          hello.SetStream(m_stream);
           hello.GetHelloMessage().SetLastChunk(m_chunks.GetLastChunk());
           double low = GetReceived(CHUNK_RECEIVED_PUSH);
           uint32_t ratio = ((low) == 0 ? 1 : (uint32_t) (floor(low * 1000)));
           hello.GetHelloMessage().SetChunksRatio(ratio);
           hello.GetHelloMessage().SetChunksReceived(m_chunks.GetBufferSize());
+          if (m_pullReplyBudget.IsEnabled())
+            hello.GetHelloMessage().SetReplyBudget(m_pullReplyBudget.GetTokens());
+          hello.GetHelloMessage().SetSubstreams(GetSubstreamMask());
 //          hello.GetHelloMessage().SetDestination(subnet);
 //          hello.GetHelloMessage().SetNeighborhoodSize(m_neighbors.GetSize());
           Ptr<Packet> packet = Create<Packet>();
           packet->AddHeader(hello);
           m_txControlTrace(packet);
           NS_LOG_DEBUG ("Node " << GetLocalAddress()<< " sends hello to "<< subnet);
-          m_socket->SendTo(packet, 0, InetSocketAddress(subnet, PUSH_PORT));
+          m_socket->SendTo(packet, 0, InetSocketAddress(subnet, m_localPort));
+          if (m_unicast) // the source is not in the neighborhood in unicast networks
+            m_socket->SendTo(packet->Copy(), 0, InetSocketAddress(GetSource(), m_localPort));
           m_helloTimer.Schedule();
           break;
         }
@@ -1575,6 +2650,660 @@ namespace ns3
       }
   }
 
+  void
+  VideoPushApplication::SendBufferMap ()
+  {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT(m_peerType == PEER);
+    uint32_t last = m_chunks.GetLastChunk();
+    if (last > 0)
+      {
+        uint32_t base = (last >= BUFFERMAP_MAX_CHUNKS ? last - BUFFERMAP_MAX_CHUNKS + 1 : 1);
+        base = (base < GetPullWBase() ? GetPullWBase() : base);
+        ChunkHeader map(MSG_BUFFERMAP);
+        map.SetStream(m_stream);
+        map.GetBufferMapMessage().SetBase(base);
+        for (uint32_t chunkid = base; chunkid <= last; chunkid++)
+          if (m_chunks.HasChunk(chunkid))
+            map.GetBufferMapMessage().SetChunk(chunkid);
+        Ptr<Packet> packet = Create<Packet>();
+        packet->AddHeader(map);
+        Ipv4Address subnet = GetLocalAddress().GetSubnetDirectedBroadcast(Ipv4Mask("255.0.0.0"));
+        NS_LOG_DEBUG ("Node " << GetLocalAddress() << " sends buffer map [" << base << ":" << last << "] to " << subnet);
+        m_txControlTrace(packet);
+        m_socket->SendTo(packet, 0, InetSocketAddress(subnet, m_localPort));
+      }
+    m_bufferMapTimer.Schedule();
+  }
+
+  void
+  VideoPushApplication::HandleBufferMap (ChunkHeader::BufferMapMessage &mapheader, const Ipv4Address &sender)
+  {
+    NS_ASSERT(m_peerType == PEER);
+    Neighbor nt(sender, m_localPort);
+    if (!m_neighbors.IsNeighbor(nt))
+      m_neighbors.AddNeighbor(nt);
+    NeighborData *data = m_neighbors.GetNeighbor(nt);
+    data->SetBufferMap(mapheader);
+    data->SetLastContact(Simulator::Now());
+    NS_LOG_DEBUG ("Node " << GetLocalAddress() << " receives buffer map from " << sender << " base " << mapheader.GetBase()
+        << " length " << mapheader.GetLength());
+    if (!m_repairPush || mapheader.GetLength() == 0)
+      return;
+    /* holes of the neighbor still playable that the node can fill */
+    uint32_t first = (mapheader.GetBase() < GetPullWBase() ? GetPullWBase() : mapheader.GetBase());
+    uint32_t last = mapheader.GetBase() + mapheader.GetLength() - 1;
+    for (uint32_t chunkid = (first > 0 ? first : 1); chunkid < last; chunkid++)
+      {
+        if (mapheader.HasChunk(chunkid) || !m_chunks.HasChunk(chunkid))
+          continue;
+        std::map<uint32_t, std::set<Ipv4Address> >::iterator sent = m_repairSent.find(chunkid);
+        if (sent != m_repairSent.end() && sent->second.find(sender) != sent->second.end())
+          continue;
+        m_repairQueue[chunkid].insert(sender);
+      }
+    if (!m_repairQueue.empty() && !m_repairTimer.IsRunning())
+      m_repairTimer.Schedule(TransmissionDelay(100, 2000, Time::US));
+  }
+
+  void
+  VideoPushApplication::RepairLoop ()
+  {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT(m_peerType == PEER && m_repairPush);
+    while (!m_repairSent.empty() && m_repairSent.begin()->first < GetPullWBase())
+      m_repairSent.erase(m_repairSent.begin());
+    while (!m_repairQueue.empty() && m_repairQueue.begin()->first < GetPullWBase()) // expired for the neighbors too
+      m_repairQueue.erase(m_repairQueue.begin());
+    if (m_repairQueue.empty())
+      return;
+    uint32_t chunkid = m_repairQueue.begin()->first; // lowest id, earliest deadline
+    std::set<Ipv4Address> targets = m_repairQueue.begin()->second;
+    ChunkVideo *copy = m_chunks.GetChunk(chunkid);
+    ChunkHeader chunk(MSG_CHUNK);
+    chunk.SetStream(m_stream);
+    chunk.SetReserved(CHUNK_FLAG_REPAIR);
+    chunk.GetChunkMessage().SetChunk(*copy);
+    chunk.GetChunkMessage().SetRequester(Ipv4Address::GetBroadcast());
+    Ptr<Packet> packet = Create<Packet>(copy->GetSize());
+    packet->AddHeader(chunk);
+    if (!m_pullReplyBudget.HasTokens(GetChunkWireSize(copy->GetSize()))) // pull replies have the priority, retry later
+      {
+        m_repairTimer.Schedule(m_pullSlot);
+        return;
+      }
+    m_repairQueue.erase(m_repairQueue.begin());
+    m_repairSent[chunkid].insert(targets.begin(), targets.end());
+    Ipv4Address destination = (targets.size() > 1 ? GetLocalAddress().GetSubnetDirectedBroadcast(Ipv4Mask("255.0.0.0"))
+        : *targets.begin());
+    NS_LOG_LOGIC ("Node " << GetLocalAddress() << " pushes repair of chunk " << chunkid << " to " << destination
+        << " for " << targets.size() << " neighbors");
+    m_pullReplyBudget.Consume(GetChunkWireSize(copy->GetSize()));
+    m_statisticsRepairTx++;
+    m_txDataPullTrace(packet);
+    m_socket->SendTo(packet, 0, InetSocketAddress(destination, m_localPort));
+    if (!m_repairQueue.empty())
+      m_repairTimer.Schedule(m_pullSlot);
+  }
+
+  void
+  VideoPushApplication::MeshLoop ()
+  {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT(m_peerType == PEER && m_meshPull);
+    uint32_t last = m_neighbors.GetLastMapChunk();
+    uint32_t first = (last > GetPullWindow() ? last - GetPullWindow() + 1 : 1);
+    first = (first < GetPullWBase() ? GetPullWBase() : first);
+    /* missing chunks not pulled yet, sorted by holders (rarest first) and then by deadline */
+    std::vector<std::pair<size_t, uint32_t> > wanted;
+    for (uint32_t chunkid = first; last > 0 && chunkid <= last; chunkid++)
+      {
+        if (m_chunks.HasChunk(chunkid) || m_chunks.GetChunkState(chunkid) == CHUNK_SKIPPED)
+          continue;
+        std::map<uint32_t, Time>::iterator req = m_meshRequested.find(chunkid);
+        if (req != m_meshRequested.end() && req->second > Simulator::Now())
+          continue;
+        std::vector<Neighbor> holders;
+        m_neighbors.GetHolders(chunkid, holders);
+        if (!holders.empty())
+          wanted.push_back(std::make_pair(holders.size(), chunkid));
+      }
+    std::sort(wanted.begin(), wanted.end());
+    std::map<Ipv4Address, uint32_t> load;
+    uint32_t sent = 0;
+    for (std::vector<std::pair<size_t, uint32_t> >::iterator iter = wanted.begin(); iter != wanted.end() && sent < m_meshPullBatch; iter++)
+      {
+        uint32_t chunkid = iter->second;
+        std::vector<Neighbor> holders;
+        m_neighbors.GetHolders(chunkid, holders);
+        /* the least loaded holder in this round, then the best link */
+        Neighbor target = holders[0];
+        for (std::vector<Neighbor>::iterator h = holders.begin() + 1; h != holders.end(); h++)
+          {
+            uint32_t hload = load[h->GetAddress()], tload = load[target.GetAddress()];
+            if (hload < tload || (hload == tload && m_neighbors.GetLinkQuality(*h) > m_neighbors.GetLinkQuality(target)))
+              target = *h;
+          }
+        load[target.GetAddress()]++;
+        Ptr<Packet> packet = ForgePull(chunkid, target.GetAddress(), PULL_FLAG_MESH);
+        AddPullRetryCurrent(chunkid);
+        SetPullTimes(chunkid);
+        StatisticAddPullRequest();
+        m_meshRequested[chunkid] = Simulator::Now() + GetPullTime();
+        NS_LOG_DEBUG ("Node " << GetNode()->GetId() << " sends mesh pull to "<< target.GetAddress() << " for chunk "<< chunkid
+            << " holders " << iter->first);
+        m_socket->SendTo(packet, 0, InetSocketAddress(target.GetAddress(), m_localPort));
+        m_txControlPullTrace(packet);
+        sent++;
+      }
+    m_meshRequested.erase(m_meshRequested.begin(), m_meshRequested.lower_bound(first));
+    m_meshTimer.Schedule();
+  }
+
+  void
+  VideoPushApplication::SendMeshReply ()
+  {
+    NS_LOG_FUNCTION (this);
+    while (!m_meshReplies.empty())
+      {
+        std::pair<uint32_t, Ipv4Address> reply = m_meshReplies.front();
+        m_meshReplies.pop_front();
+        uint32_t bytes = GetChunkWireSize(m_chunks.GetChunk(reply.first)->GetSize());
+        if (!m_pullReplyBudget.HasTokens(bytes))
+          {
+            m_statisticsPullNoBudget++;
+            continue;
+          }
+        SendChunk(reply.first, reply.second, false);
+        break;
+      }
+    if (!m_meshReplies.empty())
+      m_chunkEvent = Simulator::Schedule(PullJitter(100, 1500), &VideoPushApplication::SendMeshReply, this);
+  }
+
+  void
+  VideoPushApplication::SchedulePlayout ()
+  {
+    NS_ASSERT(!m_playout.IsRunning());
+    double playtime = ( (8.0 * m_pktSize * GetPullWindow()) / m_cbrRate.GetBitRate() );
+    m_playout.Schedule(Time::FromDouble(playtime, Time::S));
+  }
+
+  void
+  VideoPushApplication::TreeLoop ()
+  {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT(m_tree);
+    for (std::map<Ipv4Address, TreeCandidate>::iterator iter = m_treeCandidates.begin(); iter != m_treeCandidates.end();)
+      {
+        if (Simulator::Now() - iter->second.contact > m_neighbors.GetExpire())
+          m_treeCandidates.erase(iter++);
+        else
+          ++iter;
+      }
+    if (m_peerType == PEER && m_treeParent != Ipv4Address::GetAny()
+        && m_treeCandidates.find(m_treeParent) == m_treeCandidates.end()) // the parent expired
+      {
+        NS_LOG_INFO ("Node " << GetLocalAddress() << " lost tree parent " << m_treeParent);
+        TreeOrphan();
+      }
+    for (std::set<Ipv4Address>::iterator iter = m_treeChildren.begin(); iter != m_treeChildren.end();)
+      {
+        if (m_treeCandidates.find(*iter) == m_treeCandidates.end()) // connected children advertise too
+          m_treeChildren.erase(iter++);
+        else
+          ++iter;
+      }
+    Ipv4Address subnet = GetLocalAddress().GetSubnetDirectedBroadcast(Ipv4Mask("255.0.0.0"));
+    if (m_treeDepth != TREE_DEPTH_INFINITE)
+      SendTree(TREE_ADVERTISE, subnet);
+    else
+      {
+        m_treeJoining = Ipv4Address::GetAny(); // the previous join got no answer
+        TreeJoin();
+      }
+    m_treeTimer.Schedule();
+  }
+
+  void
+  VideoPushApplication::TreeJoin ()
+  {
+    NS_ASSERT(m_peerType == PEER && m_treeParent == Ipv4Address::GetAny());
+    Ipv4Address parent = Ipv4Address::GetAny();
+    uint32_t depth = TREE_DEPTH_INFINITE;
+    double quality = 0.0;
+    for (std::map<Ipv4Address, TreeCandidate>::iterator iter = m_treeCandidates.begin(); iter != m_treeCandidates.end(); iter++)
+      {
+        if (iter->second.slots == 0 || iter->second.depth == TREE_DEPTH_INFINITE)
+          continue;
+        double q = m_neighbors.GetLinkQuality(Neighbor(iter->first, m_localPort));
+        if (iter->second.depth < depth || (iter->second.depth == depth && q > quality))
+          {
+            parent = iter->first;
+            depth = iter->second.depth;
+            quality = q;
+          }
+      }
+    if (parent == Ipv4Address::GetAny())
+      return;
+    NS_LOG_INFO ("Node " << GetLocalAddress() << " joins tree via " << parent << " depth " << depth);
+    m_treeJoining = parent;
+    SendTree(TREE_JOIN, parent);
+  }
+
+  void
+  VideoPushApplication::TreeOrphan ()
+  {
+    NS_ASSERT(m_peerType == PEER);
+    for (std::set<Ipv4Address>::iterator iter = m_treeChildren.begin(); iter != m_treeChildren.end(); iter++)
+      SendTree(TREE_LEAVE, *iter);
+    m_treeChildren.clear();
+    /* candidates below our old depth may be our own descendants, joining them would make a loop */
+    for (std::map<Ipv4Address, TreeCandidate>::iterator iter = m_treeCandidates.begin(); iter != m_treeCandidates.end();)
+      {
+        if (iter->second.depth > m_treeDepth)
+          m_treeCandidates.erase(iter++);
+        else
+          ++iter;
+      }
+    m_treeParent = Ipv4Address::GetAny();
+    m_treeJoining = Ipv4Address::GetAny();
+    m_treeDepth = TREE_DEPTH_INFINITE;
+  }
+
+  uint32_t
+  VideoPushApplication::GetTreeFanout ()
+  {
+    if (!m_pullReplyBudget.IsEnabled())
+      return m_treeFanoutMax;
+    uint32_t fanout = m_pullReplyBudget.GetRate().GetBitRate() / m_cbrRate.GetBitRate();
+    return (fanout < m_treeFanoutMax ? fanout : m_treeFanoutMax);
+  }
+
+  void
+  VideoPushApplication::SendTree (TreeOpcode opcode, const Ipv4Address destination)
+  {
+    ChunkHeader tree(MSG_TREE);
+    tree.SetStream(m_stream);
+    uint32_t fanout = GetTreeFanout();
+    tree.GetTreeMessage().SetOpcode(opcode);
+    tree.GetTreeMessage().SetDepth(m_treeDepth);
+    tree.GetTreeMessage().SetSlots(fanout > m_treeChildren.size() ? fanout - m_treeChildren.size() : 0);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(tree);
+    m_txControlTrace(packet);
+    m_socket->SendTo(packet, 0, InetSocketAddress(destination, m_localPort));
+  }
+
+  void
+  VideoPushApplication::HandleTree (ChunkHeader::TreeMessage &treeheader, const Ipv4Address &sender)
+  {
+    NS_LOG_DEBUG ("Node " << GetLocalAddress() << " receives tree " << treeheader.GetOpcode() << " from " << sender
+        << " depth " << treeheader.GetDepth());
+    switch (treeheader.GetOpcode())
+      {
+      case TREE_ADVERTISE:
+        {
+          TreeCandidate candidate;
+          candidate.depth = treeheader.GetDepth();
+          candidate.slots = treeheader.GetSlots();
+          candidate.contact = Simulator::Now();
+          m_treeCandidates[sender] = candidate;
+          if (sender == m_treeParent) // the parent may have moved
+            m_treeDepth = candidate.depth + 1;
+          else if (m_peerType == PEER && m_treeParent == Ipv4Address::GetAny() && m_treeJoining == Ipv4Address::GetAny())
+            TreeJoin();
+          break;
+        }
+      case TREE_JOIN:
+        {
+          bool accept = (m_treeDepth != TREE_DEPTH_INFINITE && sender != m_treeParent
+              && (m_treeChildren.count(sender) || m_treeChildren.size() < GetTreeFanout()));
+          if (accept)
+            m_treeChildren.insert(sender);
+          NS_LOG_INFO ("Node " << GetLocalAddress() << (accept ? " accepts " : " rejects ") << sender << " as child, children "
+              << m_treeChildren.size() << "/" << GetTreeFanout());
+          SendTree(accept ? TREE_ACCEPT : TREE_REJECT, sender);
+          break;
+        }
+      case TREE_ACCEPT:
+        {
+          if (m_peerType == PEER && sender == m_treeJoining && m_treeParent == Ipv4Address::GetAny())
+            {
+              m_treeParent = sender;
+              m_treeDepth = treeheader.GetDepth() + 1;
+              m_treeJoining = Ipv4Address::GetAny();
+              NS_LOG_INFO ("Node " << GetLocalAddress() << " has joined tree via " << sender << " depth " << m_treeDepth);
+            }
+          else if (sender != m_treeParent) // late accept, release the slot
+            SendTree(TREE_LEAVE, sender);
+          break;
+        }
+      case TREE_REJECT:
+        {
+          if (sender == m_treeJoining)
+            {
+              m_treeJoining = Ipv4Address::GetAny();
+              m_treeCandidates[sender].slots = 0;
+            }
+          break;
+        }
+      case TREE_LEAVE:
+        {
+          if (m_peerType == PEER && sender == m_treeParent)
+            TreeOrphan();
+          else
+            m_treeChildren.erase(sender);
+          break;
+        }
+      default:
+        {
+          NS_ASSERT_MSG(false, "invalid tree opcode");
+          break;
+        }
+      }
+  }
+
+  void
+  VideoPushApplication::TreeForward (uint32_t chunkid, const Ipv4Address sender)
+  {
+    NS_ASSERT(m_tree && m_chunks.HasChunk(chunkid));
+    ChunkVideo *copy = m_chunks.GetChunk(chunkid);
+    for (std::set<Ipv4Address>::iterator iter = m_treeChildren.begin(); iter != m_treeChildren.end(); iter++)
+      {
+        if (*iter == sender)
+          continue;
+        ChunkHeader chunk(MSG_CHUNK);
+        chunk.SetStream(m_stream);
+        chunk.GetChunkMessage().SetChunk(*copy);
+        Ptr<Packet> packet = Create<Packet>(copy->GetSize());
+        packet->AddHeader(chunk);
+        NS_LOG_LOGIC ("Node " << GetLocalAddress() << " pushes chunk [" << *copy << "] to child " << *iter);
+        m_txDataTrace(packet);
+        m_socket->SendTo(packet, 0, InetSocketAddress(*iter, m_localPort));
+      }
+  }
+
+  uint32_t
+  VideoPushApplication::GetSubstreamMask ()
+  {
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < m_substreamPush.size(); i++)
+      if (!m_substreamPush[i].IsZero() && Simulator::Now() - m_substreamPush[i] <= m_neighbors.GetExpire())
+        mask |= (1 << i);
+    return mask;
+  }
+
+  void
+  VideoPushApplication::ClusterLoop ()
+  {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT(m_peerType == PEER);
+    double ratio = GetReceived(CHUNK_RECEIVED_PUSH);
+    double best = 0.0;
+    Ipv4Address rival = m_neighbors.GetClusterCandidate(m_clusterSinr, best);
+    double margin = (m_clusterHead ? 0.05 : 0.0); // hysteresis, avoid flapping heads
+    bool head = (rival == Ipv4Address::GetAny() || ratio + margin > best
+        || (ratio + margin == best && rival < GetLocalAddress()));
+    if (head != m_clusterHead)
+      NS_LOG_INFO ("Node " << GetLocalAddress() << (head ? " becomes" : " resigns as") << " cluster head, ratio "
+          << ratio << " best neighbor " << rival << " ratio " << best);
+    m_clusterHead = head;
+    if (m_clusterHead)
+      {
+        Time expire = m_neighbors.GetExpire();
+        for (std::map<Ipv4Address, Time>::iterator iter = m_clusterRemote.begin(); iter != m_clusterRemote.end();)
+          {
+            if (iter->second + expire < Simulator::Now())
+              m_clusterRemote.erase(iter++);
+            else
+              iter++;
+          }
+        ChunkHeader cluster(MSG_CLUSTER);
+        cluster.SetStream(m_stream);
+        cluster.GetClusterMessage().SetOpcode(CLUSTER_REGISTER);
+        Ptr<Packet> packet = Create<Packet>();
+        packet->AddHeader(cluster);
+        m_txControlTrace(packet);
+        ClusterSend(packet, GetSource());
+      }
+    else
+      m_clusterRemote.clear();
+    m_clusterTimer.Schedule();
+  }
+
+  void
+  VideoPushApplication::HandleCluster (ChunkHeader::ClusterMessage &clusterheader, const Ipv4Address &sender)
+  {
+    NS_LOG_FUNCTION (this << sender);
+    switch (m_peerType)
+      {
+      case SOURCE:
+        {
+          if (clusterheader.GetOpcode() != CLUSTER_REGISTER)
+            break;
+          m_clusterRemote[sender] = Simulator::Now();
+          Time expire = Time::FromDouble(GetHelloTime().GetSeconds() * (1.10 * (1.0 + GetHelloLoss())), Time::S);
+          std::vector<Ipv4Address> heads;
+          for (std::map<Ipv4Address, Time>::iterator iter = m_clusterRemote.begin(); iter != m_clusterRemote.end();)
+            {
+              if (iter->second + expire < Simulator::Now())
+                m_clusterRemote.erase(iter++);
+              else
+                {
+                  if (iter->first != sender)
+                    heads.push_back(iter->first);
+                  iter++;
+                }
+            }
+          if (heads.empty())
+            break;
+          ChunkHeader cluster(MSG_CLUSTER);
+          cluster.SetStream(m_stream);
+          cluster.GetClusterMessage().SetOpcode(CLUSTER_REFERRAL);
+          cluster.GetClusterMessage().SetHead(heads[UniformVariable().GetInteger(0, heads.size() - 1)]);
+          Ptr<Packet> packet = Create<Packet>();
+          packet->AddHeader(cluster);
+          NS_LOG_DEBUG ("Source refers head " << cluster.GetClusterMessage().GetHead() << " to head " << sender);
+          m_txControlTrace(packet);
+          ClusterSend(packet, sender);
+          break;
+        }
+      case PEER:
+        {
+          Ipv4Address head = clusterheader.GetHead();
+          if (clusterheader.GetOpcode() == CLUSTER_REFERRAL && m_clusterHead && head != GetLocalAddress())
+            m_clusterRemote[head] = Simulator::Now();
+          break;
+        }
+      default:
+        {
+          NS_ASSERT_MSG(false, "no valid peer state");
+          break;
+        }
+      }
+  }
+
+  Ipv4Address
+  VideoPushApplication::GetClusterRemote (const std::set<Ipv4Address> &exclude)
+  {
+    std::vector<Ipv4Address> heads;
+    for (std::map<Ipv4Address, Time>::iterator iter = m_clusterRemote.begin(); iter != m_clusterRemote.end(); iter++)
+      if (exclude.find(iter->first) == exclude.end())
+        heads.push_back(iter->first);
+    if (heads.empty())
+      return Ipv4Address::GetAny();
+    return heads[UniformVariable().GetInteger(0, heads.size() - 1)];
+  }
+
+  void
+  VideoPushApplication::SendClusterChunk (uint32_t chunkid, const Ipv4Address target)
+  {
+    NS_LOG_FUNCTION (this << chunkid << target);
+    StatisticAddPullReceived();
+    if (chunkid == 0 || !m_chunks.HasChunk(chunkid) || !m_pullReplyBudget.HasTokens(GetChunkWireSize(m_chunks.GetChunk(chunkid)->GetSize())))
+      return;
+    ChunkHeader chunk(MSG_CHUNK);
+    chunk.SetStream(m_stream);
+    ChunkVideo *copy = m_chunks.GetChunk(chunkid);
+    Ptr<Packet> packet = Create<Packet>(copy->GetSize());
+    chunk.GetChunkMessage().SetChunk(*copy);
+    chunk.GetChunkMessage().SetRequester(target);
+    packet->AddHeader(chunk);
+    NS_LOG_LOGIC ("Node " << GetLocalAddress() << " replies backbone pull to " << target << " for chunk [" << *copy << "]");
+    StatisticAddPullReply();
+    m_pullReplyBudget.Consume(GetChunkWireSize(copy->GetSize()));
+    m_txDataPullTrace(packet);
+    ClusterSend(packet, target);
+  }
+
+  void
+  VideoPushApplication::ClusterRelay (uint32_t chunkid)
+  {
+    NS_LOG_FUNCTION (this << chunkid);
+    ChunkHeader chunk(MSG_CHUNK);
+    chunk.SetStream(m_stream);
+    ChunkVideo *copy = m_chunks.GetChunk(chunkid);
+    Ptr<Packet> packet = Create<Packet>(copy->GetSize());
+    chunk.GetChunkMessage().SetChunk(*copy);
+    chunk.GetChunkMessage().SetRequester(Ipv4Address::GetBroadcast());
+    packet->AddHeader(chunk);
+    Ipv4Address subnet = GetLocalAddress().GetSubnetDirectedBroadcast(Ipv4Mask("255.0.0.0"));
+    NS_LOG_LOGIC ("Head " << GetLocalAddress() << " serves chunk " << chunkid << " recovered from another cell");
+    m_statisticsClusterRelay++;
+    m_txDataPullTrace(packet);
+    m_socket->SendTo(packet, 0, InetSocketAddress(subnet, m_localPort));
+  }
+
+  void
+  VideoPushApplication::ClusterSend (Ptr<Packet> packet, const Ipv4Address destination)
+  {
+    SendWithTtl(packet, destination, m_clusterTtl);
+  }
+
+  void
+  VideoPushApplication::SendWithTtl (Ptr<Packet> packet, const Ipv4Address destination, uint8_t ttl)
+  {
+    SocketIpTtlTag tag;
+    tag.SetTtl(ttl);
+    packet->AddPacketTag(tag);
+    m_socket->SendTo(packet, 0, InetSocketAddress(destination, m_localPort));
+  }
+
+  void
+  VideoPushApplication::ScheduleNack (uint32_t chunkid)
+  {
+    NS_ASSERT(m_peerType == PEER && m_nack);
+    uint32_t last = m_chunks.GetLastChunk();
+    if (last == 0 || chunkid <= last + 1 || !m_playout.IsRunning())
+      return;
+    uint32_t first = (chunkid - last > GetPullWindow() ? chunkid - GetPullWindow() : last + 1);
+    first = (first < GetPullWBase() ? GetPullWBase() : first);
+    for (uint32_t missed = first; missed < chunkid; missed++)
+      if (missed % m_substreams == chunkid % m_substreams && !m_chunks.HasChunk(missed))
+        m_nackMissing.insert(missed);
+    if (!m_nackMissing.empty() && !m_nackEvent.IsRunning())
+      m_nackEvent = Simulator::Schedule(TransmissionDelay(0, m_nackDelay.GetMicroSeconds(), Time::US),
+          &VideoPushApplication::SendNack, this);
+  }
+
+  void
+  VideoPushApplication::SendNack ()
+  {
+    NS_LOG_FUNCTION (this);
+    std::set<uint32_t> missing;
+    m_nackMissing.swap(missing);
+    uint32_t first = 0, count = 0;
+    for (std::set<uint32_t>::iterator iter = missing.begin(); ; iter++)
+      {
+        bool end = (iter == missing.end());
+        bool skip = (!end && (*iter < GetPullWBase() || m_chunks.HasChunk(*iter))); // repaired or expired meanwhile
+        if (!end && !skip && count > 0 && *iter == first + count && count < 0xFFFF)
+          {
+            count++;
+            continue;
+          }
+        if (count > 0) // close the current range
+          {
+            ChunkHeader nack(MSG_NACK);
+            nack.SetStream(m_stream);
+            nack.GetNackMessage().SetFirst(first);
+            nack.GetNackMessage().SetCount(count);
+            Ptr<Packet> packet = Create<Packet>();
+            packet->AddHeader(nack);
+            NS_LOG_DEBUG ("Node " << GetLocalAddress() << " sends NACK [" << first << ":" << first + count - 1 << "] to the source");
+            m_statisticsNackTx++;
+            m_txControlTrace(packet);
+            SendWithTtl(packet, GetSource(), m_nackTtl);
+            count = 0;
+          }
+        if (end)
+          break;
+        if (!skip)
+          {
+            first = *iter;
+            count = 1;
+          }
+      }
+  }
+
+  void
+  VideoPushApplication::HandleNack (ChunkHeader::NackMessage &nackheader, const Ipv4Address &sender)
+  {
+    NS_ASSERT(m_peerType == SOURCE && m_nack);
+    NS_LOG_DEBUG ("Source receives NACK [" << nackheader.GetFirst() << ":" << nackheader.GetFirst() + nackheader.GetCount() - 1
+        << "] from " << sender);
+    m_statisticsNackRx++;
+    Time holdoff = m_nackDelay + m_nackWindow; // late NACKs sent before the retransmission arrived
+    for (uint32_t chunkid = nackheader.GetFirst(); chunkid < nackheader.GetFirst() + nackheader.GetCount(); chunkid++)
+      {
+        std::map<uint32_t, Time>::iterator sent = m_nackRetransmitted.find(chunkid);
+        if (chunkid == 0 || !m_chunks.HasChunk(chunkid)
+            || (sent != m_nackRetransmitted.end() && sent->second + holdoff > Simulator::Now()))
+          continue;
+        m_nackCount[chunkid]++;
+      }
+    if (!m_nackCount.empty() && !m_nackEvent.IsRunning())
+      m_nackEvent = Simulator::Schedule(m_nackWindow, &VideoPushApplication::NackRetransmit, this);
+  }
+
+  void
+  VideoPushApplication::NackRetransmit ()
+  {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT(m_peerType == SOURCE);
+    Time holdoff = m_nackDelay + m_nackWindow;
+    for (std::map<uint32_t, Time>::iterator iter = m_nackRetransmitted.begin(); iter != m_nackRetransmitted.end();)
+      {
+        if (iter->second + holdoff < Simulator::Now())
+          m_nackRetransmitted.erase(iter++);
+        else
+          iter++;
+      }
+    for (std::map<uint32_t, uint32_t>::iterator iter = m_nackCount.begin(); iter != m_nackCount.end(); iter++)
+      {
+        if (iter->second < m_nackThreshold)
+          continue;
+        ChunkVideo *copy = m_chunks.GetChunk(iter->first);
+        ChunkHeader chunk(MSG_CHUNK);
+        chunk.SetStream(m_stream);
+        chunk.SetReserved(CHUNK_FLAG_REPAIR);
+        chunk.GetChunkMessage().SetChunk(*copy);
+        chunk.GetChunkMessage().SetRequester(Ipv4Address::GetBroadcast());
+        Ptr<Packet> packet = Create<Packet>(copy->GetSize());
+        packet->AddHeader(chunk);
+        if (!m_nackBudget.HasTokens(GetChunkWireSize(copy->GetSize()))) // out of budget, the oldest chunks went first
+          break;
+        m_nackBudget.Consume(GetChunkWireSize(copy->GetSize()));
+        NS_LOG_LOGIC ("Source retransmits chunk " << iter->first << " reported by " << iter->second << " NACKs");
+        m_nackRetransmitted[iter->first] = Simulator::Now();
+        m_statisticsNackRetx++;
+        m_txDataPullTrace(packet);
+        m_socket->SendTo(packet, 0, m_peer);
+      }
+    m_nackCount.clear();
+  }
+
 //  void
 //  VideoPushApplication::ConnectionSucceeded (Ptr<Socket>)
 //  {
@@ -1603,4 +3332,49 @@ namespace ns3
     Time delayms = Time::FromDouble(delay, unit);
     return delayms;
   }
+
+  Time
+  VideoPushApplication::PullJitter (double l, double u)
+  {
+    return TransmissionDelay(l, l + (u - l) * GetPullJitterScale(), Time::US);
+  }
+
+  double
+  VideoPushApplication::GetPullJitterScale ()
+  {
+    if (!m_pullJitterAdaptive)
+      return 1.0;
+    /* The default window fits a few contending neighbors, widen it as more of them
+     * pull after the same lost push and as pulls keep timing out. */
+    double crowd = (1.0 * m_neighbors.GetActiveSize()) / m_pullJitterNeighbors;
+    double scale = (crowd > 1.0 ? crowd : 1.0) * (1.0 + 2.0 * m_pullTimeoutRate);
+    return (scale > m_pullJitterScaleMax ? m_pullJitterScaleMax : scale);
+  }
+
+  void
+  VideoPushApplication::UpdatePullRate (bool timeout)
+  {
+    if (!m_pullRateControl)
+      return;
+    double rate = (timeout ? m_pullRate * m_pullRateDecrease : m_pullRate + m_pullRateIncrease);
+    rate = (rate < m_pullRateMin ? m_pullRateMin : rate);
+    m_pullRate = (rate > m_pullRateMax ? m_pullRateMax : rate);
+    NS_LOG_DEBUG ("Node " << GetLocalAddress() << " pull rate " << m_pullRate << " after " << (timeout ? "timeout" : "hit"));
+  }
+
+  Time
+  VideoPushApplication::GetPullPacing ()
+  {
+    if (!m_pullRateControl || m_pullLastSent.IsZero())
+      return Seconds(0);
+    Time next = m_pullLastSent + Time::FromDouble(1.0 / m_pullRate, Time::S);
+    return (next > Simulator::Now() ? next - Simulator::Now() : Seconds(0));
+  }
+
+  void
+  VideoPushApplication::UpdatePullTimeoutRate (bool timeout)
+  {
+    double alpha = 0.125;
+    m_pullTimeoutRate = (1 - alpha) * m_pullTimeoutRate + alpha * (timeout ? 1.0 : 0.0);
+  }
 } // namespace ns3
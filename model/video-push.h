@@ -28,6 +28,7 @@
 #include "chunk-buffer.h"
 #include "chunk-packet.h"
 #include "neighbor-set.h"
+#include "token-bucket.h"
 
 #include <ns3/address.h>
 #include <ns3/ipv4-address.h>
@@ -40,6 +41,9 @@
 #include <ns3/ipv4.h>
 #include <ns3/timer.h>
 #include <ns3/stats-module.h>
+#include <deque>
+#include <list>
+#include <set>
 
 namespace ns3
 {
@@ -56,7 +60,7 @@ namespace ns3
 
   enum ChunkPolicy
   {
-    CS_NEW_CHUNK, CS_LATEST, CS_LEAST_USEFUL, CS_LATEST_MISSED, CS_LEAST_MISSED
+    CS_NEW_CHUNK, CS_LATEST, CS_LEAST_USEFUL, CS_LATEST_MISSED, CS_LEAST_MISSED, CS_EARLIEST_DEADLINE
   };
 
   const uint32_t PUSH_PORT = 9999;
@@ -146,6 +150,13 @@ namespace ns3
       uint32_t
       GetPullMax () const;
 
+      /**
+       * \return max number of pull attempts for a chunk, the pull to the source included
+       * Get the neighbor pulls plus the last resort pull to the source, if enabled.
+       */
+      uint32_t
+      GetPullAttemptsMax () const;
+
       /**
        * \param window size.
        * Set the pull window size.
@@ -286,6 +297,27 @@ namespace ns3
       Ipv4Address
       GetSource () const;
 
+      /**
+       * \param subscriber Peer address.
+       * Add a peer the source pushes chunks to in unicast mode.
+       */
+      void
+      AddSubscriber (Ipv4Address subscriber);
+
+      /**
+       * \param subscriber Peer address.
+       * Stop pushing chunks to a peer in unicast mode.
+       */
+      void
+      RemoveSubscriber (Ipv4Address subscriber);
+
+      /**
+       * \return Peers the source pushes chunks to.
+       * Get the subscribers in unicast mode.
+       */
+      std::set<Ipv4Address>
+      GetSubscribers () const;
+
 //      /**
 //       * \param delay Pointer to tracker delay.
 //       * Pointer to tracker delay to collect statistics.
@@ -365,6 +397,24 @@ namespace ns3
       ChunkVideo
       ForgeChunk ();
 
+      /**
+       * \param chunkid chunk identifier.
+       * \param target Neighbor asked to reply.
+       * \param flags Pull flags.
+       * \return A new pull packet.
+       * Forge a pull message for the given chunk.
+       */
+      Ptr<Packet>
+      ForgePull (uint32_t chunkid, const Ipv4Address target, uint8_t flags);
+
+      /**
+       * \param chunkid chunk identifier.
+       * \return True if the pull for the chunk is held waiting for a reply to a neighbor.
+       * Check whether a neighbor's pull for the chunk has been overheard recently.
+       */
+      bool
+      IsPullHeld (uint32_t chunkid);
+
       /**
        * Peer Loop function.
        * Is the core function of the protocol where the source
@@ -391,13 +441,38 @@ namespace ns3
       void
       SendPacket ();
 
+      /**
+       * \param packet Packet of the new chunk.
+       * \param chunkid chunk identifier.
+       * \param interval Time before the next chunk.
+       * Queue a new chunk to all the subscribers, most lagging first, spreading the sends over the interval.
+       */
+      void
+      UnicastChunk (Ptr<Packet> packet, uint32_t chunkid, Time interval);
+
+      /**
+       * Send the queued chunk to the next subscriber.
+       */
+      void
+      SendUnicast ();
+
       /**
        * \param chunkid chunk identifier.
        * \param target neighbor address.
-       * Send a chunk to a given peer.
+       * \param broadcast True to send the reply to all neighbors, false to send it to the target only.
+       * Send a chunk in reply to a pull of the target.
+       */
+      void
+      SendChunk (uint32_t chunkid, const Ipv4Address target, bool broadcast);
+
+      /**
+       * \param chunkid chunk identifier.
+       * \param ttl Hops the copies can still be forwarded.
+       * \param sender Node the chunk has been received from.
+       * Forward a pushed chunk to a random fanout of neighbors, but the sender and the source.
        */
       void
-      SendChunk (uint32_t chunkid, const Ipv4Address target);
+      GossipChunk (uint32_t chunkid, uint8_t ttl, const Ipv4Address sender);
 
       /**
        *
@@ -408,12 +483,182 @@ namespace ns3
       void
       SendPull (uint32_t chunkid, const Ipv4Address target);
 
+      /**
+       * \param chunkid chunk identifier.
+       * \param first neighbor address the first pull was sent to.
+       * Send a second pull for a chunk still missing to a different neighbor.
+       */
+      void
+      SendHedgedPull (uint32_t chunkid, const Ipv4Address first);
+
       /**
        * Send hello message.
        */
       void
       SendHello ();
 
+      /**
+       * Send the buffer map of the chunks held within the pull window to all neighbors.
+       */
+      void
+      SendBufferMap ();
+
+      /**
+       * Schedule pulls for the missing chunks advertised in the neighbors' buffer maps,
+       * rarest chunks first, spreading the pulls over the holders.
+       */
+      void
+      MeshLoop ();
+
+      /**
+       * Push the held chunk with the earliest deadline missing from the neighbors' buffer maps.
+       */
+      void
+      RepairLoop ();
+
+      /**
+       * Send the reply to the oldest queued mesh pull.
+       */
+      void
+      SendMeshReply ();
+
+      /**
+       * Start the playout after the first chunk is received.
+       */
+      void
+      SchedulePlayout ();
+
+      /**
+       * Maintain the tree overlay: expire the parent and the children not heard anymore,
+       * advertise the node if connected, join a parent otherwise.
+       */
+      void
+      TreeLoop ();
+
+      /**
+       * Ask the closest connected neighbor with free slots to become the parent.
+       */
+      void
+      TreeJoin ();
+
+      /**
+       * Leave the tree after losing the parent, the children rejoin on their own.
+       */
+      void
+      TreeOrphan ();
+
+      /**
+       * \return Max number of children.
+       * Children allowed by the upload budget, bounded by the fanout attribute.
+       */
+      uint32_t
+      GetTreeFanout ();
+
+      /**
+       * \param opcode Tree operation.
+       * \param destination Destination address.
+       * Send a tree message with the local depth and free slots.
+       */
+      void
+      SendTree (TreeOpcode opcode, const Ipv4Address destination);
+
+      /**
+       * \param chunkid chunk identifier.
+       * \param sender Node the chunk has been received from.
+       * Push a chunk to the tree children.
+       */
+      void
+      TreeForward (uint32_t chunkid, const Ipv4Address sender);
+
+      /**
+       * Elect the cluster head of the cell from the neighbors' chunk ratio,
+       * register the head to the source and expire the heads of the other cells.
+       */
+      void
+      ClusterLoop ();
+
+      /**
+       * \param clusterheader Cluster header.
+       * \param sender Sender node.
+       * Parse a cluster message: registration at the source, referral at the cluster heads.
+       */
+      void
+      HandleCluster (ChunkHeader::ClusterMessage &clusterheader, const Ipv4Address &sender);
+
+      /**
+       * \param exclude Addresses that must not be selected.
+       * \return A random head of another cell, any if none.
+       * Select a cluster head of another cell to pull from over the backbone.
+       */
+      Ipv4Address
+      GetClusterRemote (const std::set<Ipv4Address> &exclude);
+
+      /**
+       * \param chunkid chunk identifier.
+       * \param target Cluster head of another cell.
+       * Reply to a pull received over the backbone.
+       */
+      void
+      SendClusterChunk (uint32_t chunkid, const Ipv4Address target);
+
+      /**
+       * \param chunkid chunk identifier.
+       * Serve to the whole cell a chunk recovered from another cell.
+       */
+      void
+      ClusterRelay (uint32_t chunkid);
+
+      /**
+       * \param packet Packet to send.
+       * \param destination Node in another cell or the source.
+       * Send a packet over the backbone, beyond the default TTL.
+       */
+      void
+      ClusterSend (Ptr<Packet> packet, const Ipv4Address destination);
+
+      /**
+       * \param packet Packet to send.
+       * \param destination Destination address.
+       * \param ttl IP TTL of the packet.
+       * Send a packet in unicast with the given TTL instead of the default one.
+       */
+      void
+      SendWithTtl (Ptr<Packet> packet, const Ipv4Address destination, uint8_t ttl);
+
+      /**
+       * \param chunkid chunk identifier of a pushed chunk.
+       * Schedule a NACK after a random delay for the chunks of the substream skipped by the push.
+       */
+      void
+      ScheduleNack (uint32_t chunkid);
+
+      /**
+       * Report to the source the chunks still missing, as ranges.
+       */
+      void
+      SendNack ();
+
+      /**
+       * \param nackheader NACK header.
+       * \param sender Sender node.
+       * Count the NACKs of each chunk within the aggregation window.
+       */
+      void
+      HandleNack (ChunkHeader::NackMessage &nackheader, const Ipv4Address &sender);
+
+      /**
+       * Re-multicast the chunks reported missing by enough peers, within the retransmission budget.
+       */
+      void
+      NackRetransmit ();
+
+      /**
+       * \return Substreams received in push, one bit each.
+       * Substreams pushed to the node within the neighbor expiration time.
+       */
+      uint32_t
+      GetSubstreamMask ();
+
       /**
        * \param Socket source.
        * Parse a packet received from a socket, delivering the packet to the proper handler.
@@ -425,10 +670,11 @@ namespace ns3
       /**
        * \param chunkheader Chunk header.
        * \param sender Sender node.
+       * \param flags Chunk flags.
        * Parse a chunk received.
        */
       void
-      HandleChunk (ChunkHeader::ChunkMessage &chunkheader, const Ipv4Address &sender);
+      HandleChunk (ChunkHeader::ChunkMessage &chunkheader, const Ipv4Address &sender, uint8_t flags);
 
       /**
        * \param pullheader Pull header.
@@ -436,7 +682,31 @@ namespace ns3
        * Parse a pull message.
        */
       void
-      HandlePull (ChunkHeader::PullMessage &pullheader, const Ipv4Address &sender);
+      HandlePull (ChunkHeader::PullMessage &pullheader, const Ipv4Address &sender, uint8_t flags);
+
+      /**
+       * \param pullheader Pull header.
+       * \param sender Sender node.
+       * Parse a pull addressed to another node.
+       */
+      void
+      HandleOverheardPull (ChunkHeader::PullMessage &pullheader, const Ipv4Address &sender);
+
+      /**
+       * \param chunkheader Chunk header.
+       * \param sender Sender node.
+       * Parse a pull reply addressed to another node.
+       */
+      void
+      HandleOverheardChunk (ChunkHeader::ChunkMessage &chunkheader, const Ipv4Address &sender);
+
+      /**
+       * \param sender Node requesting a chunk.
+       * \return Delay before replying to the pull.
+       * Delay before replying to a pull sent to all neighbors, shorter for neighbors with better link.
+       */
+      Time
+      SuppressionDelay (const Ipv4Address &sender);
 
       /**
        * \param helloheader Hello header.
@@ -446,6 +716,22 @@ namespace ns3
       void
       HandleHello (ChunkHeader::HelloMessage &helloheader, const Ipv4Address &sender);
 
+      /**
+       * \param mapheader Buffer map header.
+       * \param sender Sender node.
+       * Parse a buffer map message.
+       */
+      void
+      HandleBufferMap (ChunkHeader::BufferMapMessage &mapheader, const Ipv4Address &sender);
+
+      /**
+       * \param treeheader Tree header.
+       * \param sender Sender node.
+       * Parse a tree message.
+       */
+      void
+      HandleTree (ChunkHeader::TreeMessage &treeheader, const Ipv4Address &sender);
+
       /**
        * Add a pull request sent for statistics
        */
@@ -636,6 +922,19 @@ namespace ns3
       void
       UpdatePullWBase ();
 
+      /**
+       * \return Pull window size needed to repair the current loss bursts.
+       * Window size from the longest push loss burst in the window and the pull round trip time.
+       */
+      uint32_t
+      GetPullWindowTarget ();
+
+      /**
+       * Move the pull window size by one chunk towards its target, keeping the window upper bound.
+       */
+      void
+      AdaptPullWindow ();
+
       /**
        * \param chunkid chunk identifier.
        * Set the current chunk as pending in the transmission queue.
@@ -653,6 +952,14 @@ namespace ns3
       bool
       IsPending (uint32_t chunkid);
 
+      /**
+       * \param chunkid chunk identifier.
+       * \return Number of pulls waiting for the pending chunk.
+       * Get the number of pulls the pending chunk will reply to.
+       */
+      uint32_t
+      GetPending (uint32_t chunkid);
+
       /**
        * \param chunkid chunk identifier.
        * \return True if the chunk was pending, false otherwise.
@@ -699,6 +1006,74 @@ namespace ns3
       uint32_t
       GetChunkMissed () const;
 
+      /**
+       * \param chunkid chunk identifier.
+       * Mark a missed chunk as skipped, it will not be pulled anymore.
+       */
+      void
+      SkipChunk (uint32_t chunkid);
+
+      /**
+       * \param chunkid chunk identifier.
+       * \return Time left before the chunk falls out of the pull window.
+       * Remaining time to the playout of the chunk, according to the playout timer.
+       */
+      Time
+      GetChunkDeadline (uint32_t chunkid);
+
+      /**
+       * \param chunkid chunk identifier.
+       * \return True if the chunk must be skipped since a reply cannot arrive before its playout.
+       * Check the deadline of a missed chunk under the earliest deadline policy.
+       */
+      bool
+      IsPullInfeasible (uint32_t chunkid);
+
+      /**
+       * \param sample Pull round trip time sample.
+       * Update the smoothed pull round trip time.
+       */
+      void
+      UpdatePullRtt (Time sample);
+
+      /**
+       * Adjust the pull activation band from the pull outcome observed in the last control period.
+       */
+      void
+      ControlLoop ();
+
+      /**
+       * \return Smoothed pull round trip time, zero if not yet measured.
+       * Get the time between a pull and its reply.
+       */
+      Time
+      GetPullRtt () const;
+
+      /**
+       * \param percentile Percentile in [0,1].
+       * \return Percentile of the recent pull round trip times, zero if none.
+       * Get the given percentile of the pull response time.
+       */
+      Time
+      GetPullRttPercentile (double percentile);
+
+      /**
+       * \param size Chunk payload size.
+       * \return Bytes of the chunk message, headers included.
+       * Get the bytes a chunk reply charges to the upload budget.
+       */
+      uint32_t
+      GetChunkWireSize (uint32_t size) const;
+
+      /**
+       * \param chunkid chunk identifier.
+       * \return Time to wait before pulling the chunk again.
+       * Jittered exponential backoff on the pull attempts already spent for the chunk,
+       * bounded by the time left before its deadline.
+       */
+      Time
+      GetPullBackoff (uint32_t chunkid);
+
       /**
        * \param policy Chunk selection policy.
        * \return Chunk identifier according to policy, 0 otherwise.
@@ -715,6 +1090,15 @@ namespace ns3
       Neighbor
       PeerSelection (PeerPolicy policy);
 
+      /**
+       * \param policy Peer selection policy.
+       * \param exclude Neighbors that must not be selected.
+       * \return Neighbor according to policy, null otherwise.
+       * Peer selection algorithm among the neighbors not excluded.
+       */
+      Neighbor
+      PeerSelection (PeerPolicy policy, const std::set<Ipv4Address> &exclude);
+
       /**
        *
        * \param l Minimum value.
@@ -726,6 +1110,42 @@ namespace ns3
       Time
       TransmissionDelay (double l, double u, enum Time::Unit unit);
 
+      /**
+       * \param l Minimum value.
+       * \param u Maximum value.
+       * \return Random time between min and the max stretched by the contention, in microseconds.
+       * Random jitter before sending a pull or a pull reply.
+       */
+      Time
+      PullJitter (double l, double u);
+
+      /**
+       * \return Factor to stretch the pull jitter window, 1 if the jitter is not adaptive.
+       * Jitter scale from the number of active neighbors and the recent pull timeout rate.
+       */
+      double
+      GetPullJitterScale ();
+
+      /**
+       * \param timeout True if the pull has timed out, false if it has been answered.
+       * Update the moving average of the pull timeout rate.
+       */
+      void
+      UpdatePullTimeoutRate (bool timeout);
+
+      /**
+       * \param timeout True if the pull has timed out, false if it has been answered.
+       * Additive increase of the pull rate on hits, multiplicative decrease on timeouts.
+       */
+      void
+      UpdatePullRate (bool timeout);
+
+      /**
+       * \return Time to wait before the pull rate allows sending another pull.
+       */
+      Time
+      GetPullPacing ();
+
       Ptr<Socket> m_socket;                    /// Associated socket
       std::list<Ptr<Socket> > m_socketList;    /// Accepted sockets
       Address m_localAddress;                  /// Local address to bind to
@@ -747,6 +1167,9 @@ namespace ns3
       uint32_t m_maxBytes;       /// Limit total number of bytes sent
       uint32_t m_totBytes;       /// Total bytes sent so far
       uint32_t m_playoutWindow;  /// Playout window size
+      bool m_pullWindowAdaptive; /// Adapt the playout window size at runtime
+      uint32_t m_pullWindowMin;  /// Min playout window size when adaptive
+      uint32_t m_pullWindowMax;  /// Max playout window size when adaptive
       double m_chunkRatioMin;    /// Chunks' ratio within the playout window - MIN
       double m_chunkRatioMax;    /// Chunks' ratio within the playout window - MAX
 
@@ -760,11 +1183,54 @@ namespace ns3
       uint32_t m_pullReplyMax;                           /// Max number of pull replies within a pull slot
       uint32_t m_pullReplyCurrent;                       /// Current number of pull replies in the current slot
       Timer m_pullReplyTimer;                            /// Timer to reset the pull replies for the next slot
+      bool m_pullReplySuppression;                       /// Cancel replies to broadcast pulls already answered by others
+      uint32_t m_pullReplyChunk;                         /// Chunk identifier of the pending reply
+      Ipv4Address m_pullReplyTarget;                     /// Requester of the pending reply
+      Time m_pullReplyAggregation;                       /// Window to coalesce pulls for the same chunk into one reply
+      DataRate m_pullReplyRate;                          /// Upload budget for pull replies, zero for no budget
+      uint32_t m_pullReplyBurst;                         /// Max bytes of pull replies sent in a burst
+      TokenBucket m_pullReplyBudget;                     /// Budget left for pull replies
+      DataRate m_sourceReplyRate;                        /// Upload budget of the source for pull replies, zero to never reply
+      bool m_pullSource;                                 /// Send the last pull attempt for a chunk to the source
       Time m_pullTimeout;                                /// Pull timeout time
       Timer m_pullTimer;                                 /// Pull timer to pull chunks
+      uint32_t m_pullOutstanding;                        /// Chunk the pull timer is waiting for
+      Ipv4Address m_pullTarget;                          /// Neighbor the last pull has been sent to
+      bool m_pullJitterAdaptive;                         /// Scale the pull jitter with contention
+      uint32_t m_pullJitterNeighbors;                    /// Active neighbors covered by the default jitter window
+      double m_pullJitterScaleMax;                       /// Max scale of the jitter window
+      double m_pullTimeoutRate;                          /// Moving average of pull timeouts
+      bool m_pullRateControl;                            /// Pace pulls with an AIMD rate
+      double m_pullRateMin;                              /// Min pull rate (pulls/s)
+      double m_pullRateMax;                              /// Max pull rate (pulls/s)
+      double m_pullRateIncrease;                         /// Pull rate increase on hit (pulls/s)
+      double m_pullRateDecrease;                         /// Pull rate decrease factor on timeout
+      double m_pullRate;                                 /// Current pull rate (pulls/s)
+      Time m_pullLastSent;                               /// Time the last pull was sent
+      bool m_pullOverhear;                               /// Send pulls to all neighbors and hold pulls overheard
+      std::map<uint32_t, Time> m_pullHeld;               /// Chunks whose pull is held, with hold expiration
       uint32_t m_pullRetriesMax;                         /// Max number of pull attempts allowed per chunk
       uint32_t m_pullWBase;                              /// Pull window base chunk
       Timer m_playout;                                   /// Playout Timer
+      Time m_pullControlTime;                            /// Period of the pull band controller, zero to disable
+      double m_pullControlStep;                          /// Band change applied by the controller
+      uint32_t m_pullControlHysteresis;                  /// Consecutive periods agreeing before changing the band
+      Timer m_pullControlTimer;                          /// Timer of the pull band controller
+      int32_t m_pullControlTrend;                        /// Consecutive periods asking to widen (>0) or shrink (<0) the band
+      uint32_t m_pullControlRequest;                     /// Pull requests sent at the last control period
+      uint32_t m_pullControlHit;                         /// Pull hits at the last control period
+      uint32_t m_pullControlReceived;                    /// Pull requests received at the last control period
+      uint32_t m_pullControlReply;                       /// Pull replies sent at the last control period
+      uint32_t m_pullMisses;                             /// Chunks skipped or received after the playout
+      uint32_t m_pullControlMisses;                      /// Playout misses at the last control period
+      Time m_pullRtt;                                    /// Smoothed pull round trip time
+      std::deque<Time> m_pullRttSamples;                 /// Latest pull round trip time samples
+      bool m_pullHedge;                                  /// Send a second pull for chunks close to the deadline
+      double m_pullHedgePercentile;                      /// Response time percentile before hedging
+      EventId m_pullHedgeEvent;                          /// Eventid of pending "hedged pull" event
+      std::set<uint32_t> m_pullHedged;                   /// Chunks pulled twice
+      Time m_pullBackoff;                                /// Base backoff between two pulls of the same chunk
+      std::map<uint32_t, std::set<Ipv4Address> > m_pullTried; /// Neighbors already pulled for each chunk
       std::map<uint32_t, uint32_t> m_pullRetriesCurrent; /// Count pull attempts to recover a chunk
       std::map<uint32_t, Time> m_pullTimes;              /// Collect the time to recover each chunk
       std::map<uint32_t, uint32_t> m_pullPending;        /// Collect pending pulls
@@ -774,6 +1240,16 @@ namespace ns3
       uint32_t m_statisticsPullReceived; /// statistics on pull request received (RECEIVER)
       uint32_t m_statisticsPullReply;    /// statistics on pull reply sent (RECEIVER)
       uint32_t m_statisticsPullHit;      /// statistics on pull reply received (i.e., success pull) (SENDER)
+      uint32_t m_statisticsPullHedge;    /// statistics on hedged pull sent (SENDER)
+      uint32_t m_statisticsPullHedgeDup; /// statistics on late replies to hedged pulls (SENDER)
+      uint32_t m_statisticsPullSuppressed; /// statistics on pull replies suppressed (RECEIVER)
+      uint32_t m_statisticsPullHeld;     /// statistics on pulls held after overhearing a neighbor (SENDER)
+      uint32_t m_statisticsPullOverheard; /// statistics on missed chunks received from replies to neighbors (SENDER)
+      uint32_t m_statisticsPullCoalesced; /// statistics on pulls served by a shared broadcast reply (RECEIVER)
+      uint32_t m_statisticsPullDiscard;  /// statistics on pulls discarded since the reply would be late (RECEIVER)
+      uint32_t m_statisticsPullNoBudget; /// statistics on pulls not replied for lack of upload budget (RECEIVER)
+      uint32_t m_statisticsGossipTx;     /// statistics on chunk copies forwarded in gossip (SENDER)
+      uint32_t m_statisticsGossipRx;     /// statistics on fresh chunks received from gossip (RECEIVER)
 
       // HELLO CONTROL MESSAGES
       uint32_t m_helloActive;   /// Activate or not the hello mechanism
@@ -782,9 +1258,90 @@ namespace ns3
       Timer m_helloTimer;       /// Timer to send hello messages
       uint32_t m_helloLoss;     /// Max number of hello loss before removing a node as neighbor
 
+      // MESH PULL
+      Time m_bufferMapTime;                       /// Buffer map period, zero to disable buffer maps
+      Timer m_bufferMapTimer;                     /// Timer to send buffer maps
+      bool m_meshPull;                            /// Pull chunks from buffer maps instead of the pull loop
+      Time m_meshPullTime;                        /// Period of the mesh pull scheduler
+      uint32_t m_meshPullBatch;                   /// Max pulls sent at each scheduler period
+      Timer m_meshTimer;                          /// Timer of the mesh pull scheduler
+      std::map<uint32_t, Time> m_meshRequested;   /// Chunks pulled from buffer maps, with pull expiration
+      std::deque<std::pair<uint32_t, Ipv4Address> > m_meshReplies; /// Queued mesh pulls to reply
+      uint32_t m_sourceSeeds;                     /// Neighbors the source sends chunks to, zero to multicast
+
+      // REPAIR PUSH
+      bool m_repairPush;                          /// Push held chunks missing from the neighbors' buffer maps
+      Timer m_repairTimer;                        /// Timer to send the repair pushes
+      std::map<uint32_t, std::set<Ipv4Address> > m_repairQueue; /// Chunks to repair and the neighbors missing them
+      std::map<uint32_t, std::set<Ipv4Address> > m_repairSent;  /// Chunks already repaired and the neighbors served
+      uint32_t m_statisticsRepairTx;              /// Repair pushes sent
+      uint32_t m_statisticsRepairRx;              /// Fresh chunks received from repair pushes
+
+      // UNICAST FAN-OUT
+      bool m_unicast;                             /// Source pushes to the subscribers in unicast
+      std::map<Ipv4Address, uint32_t> m_subscribers; /// Subscribers and the last chunk they reported
+      std::list<Ipv4Address> m_unicastQueue;      /// Subscribers still waiting for the current chunk
+      Ptr<Packet> m_unicastPacket;                /// Chunk being sent to the subscribers
+      Time m_unicastGap;                          /// Time between two unicast sends
+      EventId m_unicastEvent;                     /// Eventid of pending "unicast tx" event
+
+      // SUBSTREAMS
+      uint32_t m_stream;                          /// Stream carried by the application
+      uint32_t m_latestChunk;                     /// Highest chunk id forged or heard of, ground truth of the statistics
+      uint32_t m_substreams;                      /// Substreams the stream is split into by chunk id
+      uint32_t m_substream;                       /// Substream pushed by the source
+      std::vector<Time> m_substreamPush;          /// Last push received for each substream
+
+      // TREE OVERLAY
+      struct TreeCandidate
+      {
+          uint32_t depth;     /// Hops from the source
+          uint32_t slots;     /// Children it can still accept
+          Time contact;       /// Last advertisement
+      };
+      bool m_tree;                                /// Push chunks down an application-level tree
+      uint32_t m_treeFanoutMax;                   /// Max children per node
+      Timer m_treeTimer;                          /// Timer to maintain the tree
+      Ipv4Address m_treeParent;                   /// Parent in the tree, any if not connected
+      Ipv4Address m_treeJoining;                  /// Neighbor asked to become the parent
+      uint32_t m_treeDepth;                       /// Hops from the source, infinite if not connected
+      std::set<Ipv4Address> m_treeChildren;       /// Children in the tree
+      std::map<Ipv4Address, TreeCandidate> m_treeCandidates; /// Connected neighbors advertising the tree
+
+      // CLUSTER HEADS
+      bool m_cluster;                             /// Elect cluster heads relaying chunks between cells
+      double m_clusterSinr;                       /// Min SINR of the neighbors in the same cell
+      uint32_t m_clusterTtl;                      /// TTL of the messages sent over the backbone
+      Timer m_clusterTimer;                       /// Timer to run the election
+      bool m_clusterHead;                         /// The node is the head of its cell
+      std::map<Ipv4Address, Time> m_clusterRemote; /// Heads of the other cells and last referral, the registry at the source
+      uint32_t m_statisticsClusterPull;           /// Pulls sent to the heads of other cells
+      uint32_t m_statisticsClusterRelay;          /// Chunks recovered from other cells and served to the cell
+
+      // NACK
+      bool m_nack;                                /// Peers report missing chunks, the source re-multicasts them
+      Time m_nackDelay;                           /// Max random delay before a NACK, the retransmission suppresses it
+      Time m_nackWindow;                          /// Time the source aggregates the NACKs
+      uint32_t m_nackTtl;                         /// TTL of the NACKs sent to the source
+      uint32_t m_nackThreshold;                   /// NACKs needed to retransmit a chunk
+      DataRate m_nackRate;                        /// Retransmission budget refill rate
+      uint32_t m_nackBurst;                       /// Max bytes retransmitted in a burst
+      TokenBucket m_nackBudget;                   /// Retransmission budget
+      EventId m_nackEvent;                        /// Eventid of pending "nack tx" or "retransmission" event
+      std::set<uint32_t> m_nackMissing;           /// Chunks to report in the next NACK
+      std::map<uint32_t, uint32_t> m_nackCount;   /// NACKs received for each chunk in the window
+      std::map<uint32_t, Time> m_nackRetransmitted; /// Chunks retransmitted and when
+      uint32_t m_statisticsNackTx;                /// NACKs sent
+      uint32_t m_statisticsNackRx;                /// NACKs received by the source
+      uint32_t m_statisticsNackRetx;              /// Chunks retransmitted by the source
+
       // CHUNK CONTROL MESSAGES
       EventId m_chunkEvent;                       /// Eventid of pending "chunk tx" event
       EventId m_loopEvent;                        /// Eventid of pending "loop" event
+      uint32_t m_gossipFanout;                    /// Neighbors a fresh pushed chunk is forwarded to, zero to disable
+      double m_gossipProbability;                 /// Probability to forward a fresh pushed chunk
+      uint32_t m_gossipTtl;                       /// Hops a pushed chunk can be forwarded by peers
+      std::list<EventId> m_gossipEvents;          /// Eventids of pending "gossip tx" events
       ChunkBuffer m_chunks;                       /// Node's chun buffer
       std::map<uint32_t, uint32_t> m_duplicates;  /// Collect the number of duplicated chunks
       std::map<uint32_t, uint64_t> m_chunk_delay; /// Collect the chunks' delay
@@ -794,6 +1351,7 @@ namespace ns3
       // NEIGHBORHOOD PART
       NeighborsSet m_neighbors;   /// Local neighborhood
       double n_selectionWeight;   /// Neighborhood weight
+      double n_banditDiscount;    /// Discount of past pull outcomes for PS_BANDIT
 
       // TRACE CALLBACK
       TracedCallback<Ptr<const Packet> > m_txDataTrace;
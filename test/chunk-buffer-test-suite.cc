@@ -33,6 +33,7 @@ ChunkBufferTestCase::DoRun (void)
 	}
 
 	NS_TEST_ASSERT_MSG_EQ(m_chunks.GetBufferSize(),size,"Buffer Size");
+	NS_TEST_ASSERT_MSG_EQ(m_chunks.GetFirstChunk(),1,"First Chunk");
 	for (uint32_t i = 1; i <1000; i++)
 	{
 		if(!m_chunks.HasChunk(i))continue;
@@ -52,6 +53,7 @@ ChunkBufferTestCase::DoRun (void)
 		}
 	}
 	NS_TEST_ASSERT_MSG_EQ(size,m_chunks.GetBufferSize(),"BufferSize");
+	NS_TEST_ASSERT_MSG_EQ(m_chunks.GetFirstChunk(),25,"First Chunk after delete");
 }
 
 class ChunkBufferStateTestCase : public TestCase {
@@ -46,6 +46,7 @@ ChunkHeaderTestCase::DoRun (void)
   msgIn.SetType(MSG_CHUNK);
   msgIn.SetReserved(0);
   msgIn.SetChecksum(61255);
+  msgIn.SetStream(7);
   msgIn.Print(std::cout);
   packet.AddHeader(msgIn);
 
@@ -56,6 +57,7 @@ ChunkHeaderTestCase::DoRun (void)
 	NS_TEST_ASSERT_MSG_EQ(msgOut.GetType(),MSG_CHUNK,"ChunkHeader Type");
 	NS_TEST_ASSERT_MSG_EQ(msgOut.GetReserved(),0,"Reserved");
 	NS_TEST_ASSERT_MSG_EQ(msgOut.GetChecksum(),61255,"Checksum");
+	NS_TEST_ASSERT_MSG_EQ(msgOut.GetStream(),7,"Stream");
   }
 
   msgIn.SetType(MSG_PULL);
@@ -96,6 +98,8 @@ ChunkTestCase::DoRun (void)
 		  streaming::ChunkHeader::ChunkMessage &chunkIn = msgIn.GetChunkMessage ();
 		  streaming::ChunkVideo video (10, 987654321, 100, 10);
 		  chunkIn.SetChunk(video);
+		  chunkIn.SetRequester(Ipv4Address("10.0.0.2"));
+		  chunkIn.SetTtl(3);
 		  chunkIn.Print(std::cout);
 	  }
 	  packet.AddHeader(msgIn);
@@ -116,6 +120,8 @@ ChunkTestCase::DoRun (void)
 		NS_TEST_ASSERT_MSG_EQ (video.c_tstamp, 987654321, "Timestamp");
 		NS_TEST_ASSERT_MSG_EQ (video.c_size, 100, "ChunkSize");
 		NS_TEST_ASSERT_MSG_EQ (video.c_attributes_size, 10, "ChunkAttributeSize");
+		NS_TEST_ASSERT_MSG_EQ (chunkOut.GetRequester(), Ipv4Address("10.0.0.2"), "Requester");
+		NS_TEST_ASSERT_MSG_EQ ((uint32_t) chunkOut.GetTtl(), 3, "TTL");
 	  }
 }
 
@@ -140,6 +146,8 @@ PullTestCase::DoRun (void)
 	  {
 	    streaming::ChunkHeader::PullMessage &chunkIn = msgIn.GetPullMessage ();
 	    chunkIn.SetChunk(5);
+	    chunkIn.SetTarget(Ipv4Address("10.0.0.3"));
+	    chunkIn.SetDeadline(250000);
 	    chunkIn.Print(std::cout);
 	  }
 	  packet.AddHeader(msgIn);
@@ -154,6 +162,8 @@ PullTestCase::DoRun (void)
 	  streaming::ChunkHeader::PullMessage &chunkOut = msgIn.GetPullMessage ();
 	  {
 		  NS_TEST_ASSERT_MSG_EQ (chunkOut.GetChunk(), 5, "ChunkIdentifier PULL");
+		  NS_TEST_ASSERT_MSG_EQ (chunkOut.GetTarget(), Ipv4Address("10.0.0.3"), "Target PULL");
+		  NS_TEST_ASSERT_MSG_EQ (chunkOut.GetDeadline(), 250000, "Deadline PULL");
 		  chunkOut.Print(std::cout);
 	  }
 	  }
@@ -182,6 +192,8 @@ HelloTestCase::DoRun (void)
 	    chunkIn.SetLastChunk (1223);
 	    chunkIn.SetChunksReceived (1023);
 	    chunkIn.SetChunksRatio (80);
+	    chunkIn.SetReplyBudget (6400);
+	    chunkIn.SetSubstreams (0x5);
 //	    chunkIn.SetDestination (Ipv4Address("10.1.2.3"));
 //	    chunkIn.SetNeighborhoodSize (8);
 	    chunkIn.Print(std::cout);
@@ -200,12 +212,187 @@ HelloTestCase::DoRun (void)
 		  NS_TEST_ASSERT_MSG_EQ (chunkOut.GetLastChunk(), 1223, "Last Chunk");
 		  NS_TEST_ASSERT_MSG_EQ (chunkOut.GetChunksReceived(), 1023, "Chunks Received");
 		  NS_TEST_ASSERT_MSG_EQ (chunkOut.GetChunksRatio(), 80, "Chunks Ratio");
+		  NS_TEST_ASSERT_MSG_EQ (chunkOut.GetReplyBudget(), 6400, "Reply Budget");
+		  NS_TEST_ASSERT_MSG_EQ (chunkOut.GetSubstreams(), 0x5, "Substreams");
 //		  NS_TEST_ASSERT_MSG_EQ (chunkOut.GetDestination(), Ipv4Address("10.1.2.3"), "Ip destination");
 //		  NS_TEST_ASSERT_MSG_EQ (chunkOut.GetNeighborhoodSize(), 8, "Neighborhood Size");
 		  chunkOut.Print(std::cout);
 	  }
 	  }
 }
+class BufferMapTestCase : public TestCase {
+public:
+	BufferMapTestCase ();
+  virtual void DoRun (void);
+};
+
+BufferMapTestCase::BufferMapTestCase ()
+  : TestCase ("Check BufferMapMessage")
+{}
+void
+BufferMapTestCase::DoRun (void)
+{
+	  Packet packet;
+	  streaming::ChunkHeader msgIn;
+	  msgIn.SetType(MSG_BUFFERMAP);
+	  msgIn.SetReserved(0);
+	  msgIn.SetChecksum(12345);
+	  {
+	    streaming::ChunkHeader::BufferMapMessage &mapIn = msgIn.GetBufferMapMessage ();
+	    mapIn.SetBase (100);
+	    mapIn.SetChunk (100);
+	    mapIn.SetChunk (107);
+	    mapIn.SetChunk (117);
+	    mapIn.Print(std::cout);
+	  }
+	  packet.AddHeader(msgIn);
+	  NS_TEST_ASSERT_MSG_EQ (packet.GetSize(), CHUNK_HEADER_SIZE + MSG_BUFFERMAP_SIZE + 3, "Map size");
+
+	  streaming::ChunkHeader msgOut;
+	  packet.RemoveHeader (msgOut);
+	  msgOut.Print(std::cout);
+	  {
+	  NS_TEST_ASSERT_MSG_EQ(msgOut.GetType(),MSG_BUFFERMAP,"ChunkHeader Type");
+	  NS_TEST_ASSERT_MSG_EQ(msgOut.GetChecksum(),12345,"Checksum");
+	  streaming::ChunkHeader::BufferMapMessage &mapOut = msgOut.GetBufferMapMessage ();
+	  {
+		  NS_TEST_ASSERT_MSG_EQ (mapOut.GetBase(), 100, "Base");
+		  NS_TEST_ASSERT_MSG_EQ (mapOut.GetLength(), 24, "Length");
+		  NS_TEST_ASSERT_MSG_EQ (mapOut.HasChunk(100), true, "First chunk");
+		  NS_TEST_ASSERT_MSG_EQ (mapOut.HasChunk(107), true, "Byte boundary");
+		  NS_TEST_ASSERT_MSG_EQ (mapOut.HasChunk(117), true, "Last chunk");
+		  NS_TEST_ASSERT_MSG_EQ (mapOut.HasChunk(101), false, "Missing chunk");
+		  NS_TEST_ASSERT_MSG_EQ (mapOut.HasChunk(99), false, "Before base");
+		  NS_TEST_ASSERT_MSG_EQ (mapOut.HasChunk(200), false, "After map");
+		  mapOut.Print(std::cout);
+	  }
+	  }
+}
+
+class TreeTestCase : public TestCase {
+public:
+	TreeTestCase ();
+  virtual void DoRun (void);
+};
+
+TreeTestCase::TreeTestCase ()
+  : TestCase ("Check TreeMessage")
+{}
+void
+TreeTestCase::DoRun (void)
+{
+	  Packet packet;
+	  streaming::ChunkHeader msgIn;
+	  msgIn.SetType(MSG_TREE);
+	  msgIn.SetReserved(0);
+	  msgIn.SetChecksum(4321);
+	  {
+	    streaming::ChunkHeader::TreeMessage &treeIn = msgIn.GetTreeMessage ();
+	    treeIn.SetOpcode (TREE_ACCEPT);
+	    treeIn.SetSlots (3);
+	    treeIn.SetDepth (2);
+	    treeIn.Print(std::cout);
+	  }
+	  packet.AddHeader(msgIn);
+
+	  streaming::ChunkHeader msgOut;
+	  packet.RemoveHeader (msgOut);
+	  msgOut.Print(std::cout);
+	  {
+	  NS_TEST_ASSERT_MSG_EQ(msgOut.GetType(),MSG_TREE,"ChunkHeader Type");
+	  NS_TEST_ASSERT_MSG_EQ(msgOut.GetChecksum(),4321,"Checksum");
+	  streaming::ChunkHeader::TreeMessage &treeOut = msgOut.GetTreeMessage ();
+	  {
+		  NS_TEST_ASSERT_MSG_EQ (treeOut.GetOpcode(), TREE_ACCEPT, "Opcode");
+		  NS_TEST_ASSERT_MSG_EQ (treeOut.GetSlots(), 3, "Free Slots");
+		  NS_TEST_ASSERT_MSG_EQ (treeOut.GetDepth(), 2, "Depth");
+		  treeOut.Print(std::cout);
+	  }
+	  }
+}
+
+class ClusterTestCase : public TestCase {
+public:
+	ClusterTestCase ();
+  virtual void DoRun (void);
+};
+
+ClusterTestCase::ClusterTestCase ()
+  : TestCase ("Check ClusterMessage")
+{}
+void
+ClusterTestCase::DoRun (void)
+{
+	  Packet packet;
+	  streaming::ChunkHeader msgIn;
+	  msgIn.SetType(MSG_CLUSTER);
+	  msgIn.SetReserved(0);
+	  msgIn.SetChecksum(4321);
+	  {
+	    streaming::ChunkHeader::ClusterMessage &clusterIn = msgIn.GetClusterMessage ();
+	    clusterIn.SetOpcode (CLUSTER_REFERRAL);
+	    clusterIn.SetHead (Ipv4Address ("10.0.2.7"));
+	    clusterIn.Print(std::cout);
+	  }
+	  packet.AddHeader(msgIn);
+	  NS_TEST_ASSERT_MSG_EQ(packet.GetSize(),CHUNK_HEADER_SIZE+MSG_CLUSTER_SIZE,"Cluster Size");
+
+	  streaming::ChunkHeader msgOut;
+	  packet.RemoveHeader (msgOut);
+	  msgOut.Print(std::cout);
+	  {
+	  NS_TEST_ASSERT_MSG_EQ(msgOut.GetType(),MSG_CLUSTER,"ChunkHeader Type");
+	  NS_TEST_ASSERT_MSG_EQ(msgOut.GetChecksum(),4321,"Checksum");
+	  streaming::ChunkHeader::ClusterMessage &clusterOut = msgOut.GetClusterMessage ();
+	  {
+		  NS_TEST_ASSERT_MSG_EQ (clusterOut.GetOpcode(), CLUSTER_REFERRAL, "Opcode");
+		  NS_TEST_ASSERT_MSG_EQ (clusterOut.GetHead(), Ipv4Address ("10.0.2.7"), "Head");
+		  clusterOut.Print(std::cout);
+	  }
+	  }
+}
+
+class NackTestCase : public TestCase {
+public:
+	NackTestCase ();
+  virtual void DoRun (void);
+};
+
+NackTestCase::NackTestCase ()
+  : TestCase ("Check NackMessage")
+{}
+void
+NackTestCase::DoRun (void)
+{
+	  Packet packet;
+	  streaming::ChunkHeader msgIn;
+	  msgIn.SetType(MSG_NACK);
+	  msgIn.SetReserved(0);
+	  msgIn.SetChecksum(4321);
+	  {
+	    streaming::ChunkHeader::NackMessage &nackIn = msgIn.GetNackMessage ();
+	    nackIn.SetFirst (70000);
+	    nackIn.SetCount (12);
+	    nackIn.Print(std::cout);
+	  }
+	  packet.AddHeader(msgIn);
+	  NS_TEST_ASSERT_MSG_EQ(packet.GetSize(),CHUNK_HEADER_SIZE+MSG_NACK_SIZE,"Nack Size");
+
+	  streaming::ChunkHeader msgOut;
+	  packet.RemoveHeader (msgOut);
+	  msgOut.Print(std::cout);
+	  {
+	  NS_TEST_ASSERT_MSG_EQ(msgOut.GetType(),MSG_NACK,"ChunkHeader Type");
+	  NS_TEST_ASSERT_MSG_EQ(msgOut.GetChecksum(),4321,"Checksum");
+	  streaming::ChunkHeader::NackMessage &nackOut = msgOut.GetNackMessage ();
+	  {
+		  NS_TEST_ASSERT_MSG_EQ (nackOut.GetFirst(), 70000, "First");
+		  NS_TEST_ASSERT_MSG_EQ (nackOut.GetCount(), 12, "Count");
+		  nackOut.Print(std::cout);
+	  }
+	  }
+}
+
 static class ChunkTestSuite : public TestSuite
 {
 public:
@@ -220,6 +407,10 @@ ChunkTestSuite::ChunkTestSuite()
   AddTestCase(new ChunkTestCase());
   AddTestCase(new PullTestCase());
   AddTestCase(new HelloTestCase());
+  AddTestCase(new BufferMapTestCase());
+  AddTestCase(new TreeTestCase());
+  AddTestCase(new ClusterTestCase());
+  AddTestCase(new NackTestCase());
 }
 
 } // namespace ns3
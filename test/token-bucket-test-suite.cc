@@ -0,0 +1,61 @@
+#include "ns3/test.h"
+#include "ns3/token-bucket.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+class TokenBucketTestCase : public TestCase {
+public:
+	TokenBucketTestCase ();
+	virtual void DoRun (void);
+	void Check (uint32_t expected);
+	TokenBucket m_bucket;
+};
+
+TokenBucketTestCase::TokenBucketTestCase ()
+  : TestCase ("Check Token Bucket")
+{}
+
+void
+TokenBucketTestCase::Check (uint32_t expected)
+{
+	NS_TEST_ASSERT_MSG_EQ(m_bucket.GetTokens(), expected, "Refill");
+}
+
+void
+TokenBucketTestCase::DoRun (void)
+{
+	TokenBucket disabled;
+	NS_TEST_ASSERT_MSG_EQ(disabled.IsEnabled(), false, "Disabled");
+	NS_TEST_ASSERT_MSG_EQ(disabled.HasTokens(100000), true, "Disabled HasTokens");
+	NS_TEST_ASSERT_MSG_EQ(disabled.Consume(100000), true, "Disabled Consume");
+
+	m_bucket.SetRate(DataRate("80kbps")); // 10000 bytes/s
+	m_bucket.SetSize(5000);
+	NS_TEST_ASSERT_MSG_EQ(m_bucket.IsEnabled(), true, "Enabled");
+	NS_TEST_ASSERT_MSG_EQ(m_bucket.GetTokens(), 5000, "Full bucket");
+	NS_TEST_ASSERT_MSG_EQ(m_bucket.HasTokens(4000), true, "HasTokens");
+	NS_TEST_ASSERT_MSG_EQ(m_bucket.Consume(4000), true, "Consume");
+	NS_TEST_ASSERT_MSG_EQ(m_bucket.GetTokens(), 1000, "Tokens left");
+	NS_TEST_ASSERT_MSG_EQ(m_bucket.HasTokens(2000), false, "Not enough tokens");
+	NS_TEST_ASSERT_MSG_EQ(m_bucket.Consume(2000), false, "Consume too much");
+	NS_TEST_ASSERT_MSG_EQ(m_bucket.GetTokens(), 0, "Empty bucket");
+	Simulator::Schedule(Seconds(0.2), &TokenBucketTestCase::Check, this, 2000);
+	Simulator::Schedule(Seconds(10), &TokenBucketTestCase::Check, this, 5000);
+	Simulator::Run();
+	Simulator::Destroy();
+}
+
+static class TokenBucketTestSuite : public TestSuite
+{
+public:
+	TokenBucketTestSuite ();
+} j_tokenBucketTestSuite;
+
+TokenBucketTestSuite::TokenBucketTestSuite()
+  : TestSuite("token-bucket", UNIT)
+{
+	/// ./test.py -s token-bucket -v -c unit 1
+  AddTestCase(new TokenBucketTestCase ());
+}
+}
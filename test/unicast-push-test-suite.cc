@@ -0,0 +1,116 @@
+#include "ns3/test.h"
+#include "ns3/video-push.h"
+#include "ns3/video-helper.h"
+#include "ns3/chunk-packet.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/csma-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/address.h"
+#include "ns3/data-rate.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+class UnicastPushTestCase : public TestCase {
+public:
+	UnicastPushTestCase ();
+	virtual void DoRun (void);
+	void Receive (Ptr<Socket> socket);
+	std::map<Ptr<Socket>, std::vector<uint32_t> > m_received;
+};
+
+UnicastPushTestCase::UnicastPushTestCase ()
+  : TestCase ("Check Unicast Fan-out")
+{}
+
+void
+UnicastPushTestCase::Receive (Ptr<Socket> socket)
+{
+	Ptr<Packet> packet;
+	while ((packet = socket->Recv()))
+	{
+		ChunkHeader chunkH (MSG_CHUNK);
+		packet->RemoveHeader(chunkH);
+		if (chunkH.GetType() == MSG_CHUNK) // the source hellos are broadcast
+			m_received[socket].push_back(chunkH.GetChunkMessage().GetChunk().c_id);
+	}
+}
+
+void
+UnicastPushTestCase::DoRun (void)
+{
+	NodeContainer nodes;
+	nodes.Create(4);
+	CsmaHelper csma;
+	csma.SetChannelAttribute ("DataRate", DataRateValue (DataRate ("100Mbps")));
+	NetDeviceContainer devices = csma.Install(nodes);
+	InternetStackHelper stack;
+	stack.Install(nodes);
+	Ipv4AddressHelper address;
+	address.SetBase ("10.1.1.0", "255.255.255.0");
+	Ipv4InterfaceContainer interfaces = address.Assign(devices);
+
+	VideoHelper video ("ns3::UdpSocketFactory", InetSocketAddress (interfaces.GetAddress(0).GetSubnetDirectedBroadcast("255.255.255.0"), PUSH_PORT));
+	video.SetAttribute ("DataRate", DataRateValue (DataRate ("80kbps"))); // 10 chunks/s
+	video.SetAttribute ("PacketSize", UintegerValue (1000));
+	video.SetAttribute ("PeerType", EnumValue (SOURCE));
+	video.SetAttribute ("Local", AddressValue (interfaces.GetAddress(0)));
+	video.SetAttribute ("Unicast", BooleanValue (true));
+	ApplicationContainer apps = video.Install(nodes.Get(0));
+	apps.Start(Seconds(0.0));
+	apps.Stop(Seconds(2.0));
+	Ptr<VideoPushApplication> source = DynamicCast<VideoPushApplication> (apps.Get(0));
+
+	std::vector<Ptr<Socket> > sockets;
+	for (uint32_t n = 1; n < nodes.GetN(); n++)
+	{
+		Ptr<Socket> socket = Socket::CreateSocket(nodes.Get(n), UdpSocketFactory::GetTypeId());
+		socket->Bind(InetSocketAddress(PUSH_PORT));
+		socket->SetRecvCallback(MakeCallback(&UnicastPushTestCase::Receive, this));
+		sockets.push_back(socket);
+		source->AddSubscriber(interfaces.GetAddress(n));
+	}
+	NS_TEST_ASSERT_MSG_EQ(source->GetSubscribers().size(), 3, "Subscribers");
+	Simulator::Schedule(Seconds(1.0) + MilliSeconds(50), &VideoPushApplication::RemoveSubscriber, source, interfaces.GetAddress(3));
+	Simulator::Stop(Seconds(3.0));
+	Simulator::Run();
+
+	std::vector<uint32_t> &first = m_received[sockets[0]];
+	NS_TEST_ASSERT_MSG_GT(first.size(), 15, "Chunks pushed");
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		std::vector<uint32_t> &chunks = m_received[sockets[i]];
+		NS_TEST_ASSERT_MSG_EQ(chunks.size(), first.size(), "Same chunks to all the subscribers");
+		for (uint32_t c = 0; c < chunks.size(); c++)
+			NS_TEST_ASSERT_MSG_EQ(chunks[c], c + 1, "Each chunk once and in order");
+	}
+	std::vector<uint32_t> &removed = m_received[sockets[2]];
+	NS_TEST_ASSERT_MSG_LT(removed.size(), first.size(), "No chunks after the removal");
+	for (uint32_t c = 0; c < removed.size(); c++)
+		NS_TEST_ASSERT_MSG_EQ(removed[c], c + 1, "Each chunk once and in order before the removal");
+	for (uint32_t i = 0; i < sockets.size(); i++)
+		sockets[i]->Close();
+	Simulator::Destroy();
+}
+
+static class UnicastPushTestSuite : public TestSuite
+{
+public:
+	UnicastPushTestSuite ();
+} j_unicastPushTestSuite;
+
+UnicastPushTestSuite::UnicastPushTestSuite()
+  : TestSuite("unicast-push", SYSTEM)
+{
+	/// ./test.py -s unicast-push -v -c system
+  AddTestCase(new UnicastPushTestCase ());
+}
+}